@@ -0,0 +1,654 @@
+#include <simple-ecs/ECS.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks of the core operations over entity counts, component counts, churn rates and thread counts.
+// usage: SimpleECS_bench [--entities 1000,10000,100000,1000000] [--components 1,4,8] [--churn 0.01,0.1]
+//                        [--threads 1,8] [--repeats 5] [--filter world.] [--format text|json|csv] [--out file]
+
+namespace {
+
+template<std::size_t I>
+struct Value {
+    float x, y, z, w;
+};
+
+constexpr std::size_t MAX_COMPONENTS = 8;
+
+using Moving  = Filter<Require<Value<0>, Value<1>>>;
+using Damaged = Filter<Require<Value<2>>, Exclude<Value<3>>>;
+using Tagged  = Filter<Require<Value<0>, Value<4>>>;
+
+struct Params {
+    std::size_t entities   = 0;
+    std::size_t components = 0; // zero if the benchmark doesn't depend on the parameter
+    double      churn      = 0.; // share of the entities replaced every frame
+    std::size_t threads    = 0;
+};
+
+struct Sample {
+    double      seconds = 0.;
+    std::size_t ops     = 0;
+};
+
+struct Benchmark {
+    std::string_view name;
+    bool             by_components = false;
+    bool             by_churn      = false;
+    bool             by_threads    = false;
+    Sample (*run)(const Params&)   = nullptr;
+};
+
+struct Result {
+    std::string_view name;
+    Params           params;
+    std::size_t      ops    = 0;
+    double           best   = 0.; // seconds
+    double           median = 0.;
+};
+
+struct Options {
+    std::vector<std::size_t> entities   = {1'000, 10'000, 100'000, 1'000'000};
+    std::vector<std::size_t> components = {1, 4, 8};
+    std::vector<double>      churn      = {0.01, 0.1};
+    std::vector<std::size_t> threads    = {1, std::max(1U, std::thread::hardware_concurrency())};
+    std::size_t              repeats    = 5;
+    std::string_view         filter;
+    std::string_view         format = "text";
+    std::string_view         out;
+};
+
+
+// Observer iteration is measured inside the function, so the frame overhead is not included
+double g_iteration = 0.;
+
+void iterate(OBSERVER(Moving) observer) {
+    spdlog::stopwatch sw;
+    for (auto e : observer) {
+        auto&       position = e.get<Value<0>>();
+        const auto& velocity = e.get<const Value<1>>();
+        position.x += velocity.x;
+    }
+    g_iteration = sw.elapsed().count();
+}
+
+void iterateTuple(OBSERVER(Moving) observer) {
+    spdlog::stopwatch sw;
+    for (auto e : observer) {
+        auto [position, velocity] = e.get();
+        position.x += velocity.x;
+    }
+    g_iteration = sw.elapsed().count();
+}
+
+void move(OBSERVER(Moving) observer) {
+    for (auto e : observer) {
+        auto [position, velocity] = e.get();
+        position.x += velocity.x;
+        position.y += velocity.y;
+    }
+}
+
+void heal(OBSERVER(Damaged) observer) {
+    for (auto e : observer) {
+        e.get<Value<2>>().w += 1.F;
+    }
+}
+
+void drift(OBSERVER(Tagged) observer) {
+    for (auto e : observer) {
+        e.get<Value<4>>().z += e.get<const Value<0>>().z;
+    }
+}
+
+
+template<std::size_t... I>
+void registerComponents(World& w, std::index_sequence<I...>) {
+    ComponentRegistrant<Value<I>...>(w).createStorage().addSerialize();
+}
+
+// components [first, last) are added through the storages, so observers are not notified
+template<std::size_t... I>
+void emplace(World& w, std::span<const Entity> ents, std::size_t first, std::size_t last, std::index_sequence<I...>) {
+    auto add = [&]<std::size_t N>() {
+        if (N >= first && N < last) {
+            auto& storage = w.storage<Value<N>>();
+            for (auto e : ents) {
+                auto f = static_cast<float>(e);
+                storage.emplace(e, Value<N>{f, f, f, f});
+            }
+        }
+    };
+    (add.template operator()<I>(), ...);
+}
+
+// `ents` must be sorted
+template<std::size_t... I>
+void erase(World& w, std::span<const Entity> ents, std::size_t count, std::index_sequence<I...>) {
+    ((I < count ? w.storage<Value<I>>().erase(ents) : void()), ...);
+}
+
+template<std::size_t... I>
+std::size_t filterAnd(const World& w, std::index_sequence<I...>) {
+    return FilteredEntities<AND<Components<Value<I>...>>>::ents(w)->size();
+}
+
+template<std::size_t... K>
+constexpr auto filtersAnd(std::index_sequence<K...>) {
+    return std::array{+[](const World& w) { return filterAnd(w, std::make_index_sequence<K + 1>{}); }...};
+}
+
+constexpr auto FILTERS_AND = filtersAnd(std::make_index_sequence<MAX_COMPONENTS>{});
+
+
+std::unique_ptr<World> makeWorld() {
+    auto w = std::make_unique<World>();
+    registerComponents(*w, std::make_index_sequence<MAX_COMPONENTS>{});
+    return w;
+}
+
+std::vector<Entity> createEntities(World& w, std::size_t count) {
+    std::vector<Entity> ents(count);
+    w.create(ents);
+    return ents;
+}
+
+// entities of the frame benchmarks, every filter gets a part of them
+void populate(World& w, std::span<const Entity> ents) {
+    for (auto e : ents) {
+        auto f = static_cast<float>(e);
+        w.emplace<Value<0>>(e, Value<0>{f, f, f, f});
+        w.emplace<Value<1>>(e, Value<1>{1.F, 1.F, 0.F, 0.F});
+        if (e % 2) {
+            w.emplace<Value<2>>(e, Value<2>{});
+        }
+        if (e % 4 == 0) {
+            w.emplace<Value<3>>(e, Value<3>{});
+        }
+        if (e % 3 == 0) {
+            w.emplace<Value<4>>(e, Value<4>{});
+        }
+    }
+}
+
+
+Sample worldCreate(const Params& params) {
+    auto w = makeWorld();
+
+    spdlog::stopwatch sw;
+    for (std::size_t i = 0; i < params.entities; ++i) {
+        std::ignore = w->create();
+    }
+    return {sw.elapsed().count(), params.entities};
+}
+
+Sample worldCreateBatch(const Params& params) {
+    auto                w = makeWorld();
+    std::vector<Entity> ents(params.entities);
+
+    spdlog::stopwatch sw;
+    w->create(ents);
+    return {sw.elapsed().count(), params.entities};
+}
+
+Sample worldDestroy(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    emplace(*w, ents, 0, params.components, std::make_index_sequence<MAX_COMPONENTS>{});
+
+    spdlog::stopwatch sw;
+    w->destroy(ents);
+    w->flush();
+    return {sw.elapsed().count(), params.entities};
+}
+
+Sample storageEmplace(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+
+    spdlog::stopwatch sw;
+    emplace(*w, ents, 0, params.components, std::make_index_sequence<MAX_COMPONENTS>{});
+    return {sw.elapsed().count(), params.entities * params.components};
+}
+
+Sample storageErase(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    emplace(*w, ents, 0, params.components, std::make_index_sequence<MAX_COMPONENTS>{});
+
+    // every other entity, the bulk erase takes a sorted list
+    std::vector<Entity> erased;
+    for (std::size_t i = 0; i < ents.size(); i += 2) {
+        erased.emplace_back(ents[i]);
+    }
+
+    spdlog::stopwatch sw;
+    erase(*w, erased, params.components, std::make_index_sequence<MAX_COMPONENTS>{});
+    return {sw.elapsed().count(), erased.size() * params.components};
+}
+
+// every entity is marked one by one, as systems do after writing a component
+template<bool Tick>
+Sample storageMark(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    emplace(*w, ents, 0, 1, std::make_index_sequence<MAX_COMPONENTS>{});
+    if constexpr (!Tick) {
+        w->trackUpdates<Value<0>>(); // the tag storage is created by the first `markUpdated`, not timed
+    }
+
+    spdlog::stopwatch sw;
+    for (auto e : ents) {
+        if constexpr (Tick) {
+            w->markChanged<Value<0>>(e);
+        } else {
+            w->markUpdated<Value<0>>(e);
+        }
+    }
+    if constexpr (!Tick) {
+        w->clearUpdateTag<Value<0>>(std::span<const Entity>(ents));
+    }
+    return {sw.elapsed().count(), params.entities};
+}
+
+Sample filterEntities(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+
+    // the first component is on every entity, the next ones are on every 2nd, 4th and 8th entity
+    for (std::size_t i = 0; i < params.components; ++i) {
+        auto                step = std::size_t{1} << std::min<std::size_t>(i, 3);
+        std::vector<Entity> part;
+        std::ranges::copy_if(ents, std::back_inserter(part), [step](Entity e) { return e % step == 0; });
+        emplace(*w, part, i, i + 1, std::make_index_sequence<MAX_COMPONENTS>{});
+    }
+
+    spdlog::stopwatch                sw;
+    [[maybe_unused]] std::size_t size = FILTERS_AND[params.components - 1](*w);
+    return {sw.elapsed().count(), params.entities};
+}
+
+template<auto Function>
+Sample observerIterate(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    populate(*w, ents);
+
+    auto& reg = *w->getRegistry();
+    if constexpr (Function == &iterate) {
+        ECS_REG_EXTERN_FUNC(reg, iterate);
+    } else {
+        ECS_REG_EXTERN_FUNC(reg, iterateTuple);
+    }
+    reg.initNewSystems();
+
+    // the first frame refreshes the observer
+    reg.prepare();
+    reg.exec();
+    reg.prepare();
+    reg.exec();
+    return {g_iteration, params.entities};
+}
+
+Sample frame(const Params& params) {
+    JobScheduler::thread_count    = params.threads;
+    ObserverManager::thread_count = params.threads;
+
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    populate(*w, ents);
+
+    auto& reg = *w->getRegistry();
+    ECS_REG_EXTERN_FUNC(reg, move);
+    ECS_REG_EXTERN_FUNC(reg, heal);
+    ECS_REG_EXTERN_FUNC(reg, drift);
+    reg.initNewSystems();
+    reg.prepare();
+    reg.exec();
+
+    constexpr std::size_t FRAMES = 20;
+
+    // the oldest entities are replaced by the new ones
+    const auto          churn = std::max<std::size_t>(1, static_cast<std::size_t>(params.churn * params.entities));
+    std::vector<Entity> created(churn);
+    std::size_t         oldest = 0;
+
+    spdlog::stopwatch sw;
+    for (std::size_t i = 0; i < FRAMES; ++i) {
+        for (std::size_t j = 0; j < churn; ++j) {
+            w->destroy(ents[oldest]);
+            oldest = (oldest + 1) % ents.size();
+        }
+
+        reg.prepare();
+        reg.exec();
+
+        w->create(created);
+        populate(*w, created);
+        for (std::size_t j = 0; j < churn; ++j) {
+            ents[(oldest + ents.size() - churn + j) % ents.size()] = created[j];
+        }
+    }
+    return {sw.elapsed().count(), FRAMES};
+}
+
+Sample serializerSave(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    populate(*w, ents);
+    w->getRegistry()->initNewSystems();
+
+    spdlog::stopwatch sw;
+    auto              data = w->getRegistry()->serializer().save();
+    return {sw.elapsed().count(), params.entities};
+}
+
+Sample serializerLoad(const Params& params) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, params.entities);
+    populate(*w, ents);
+    w->getRegistry()->initNewSystems();
+
+    auto data = w->getRegistry()->serializer().save();
+    w->destroy(ents);
+    w->flush();
+
+    spdlog::stopwatch     sw;
+    [[maybe_unused]] bool ok = w->getRegistry()->serializer().load(data);
+    auto                  seconds = sw.elapsed().count();
+    assert(ok && "Snapshot is not loaded");
+    return {seconds, params.entities};
+}
+
+// world with free ids, so the free list is copied too
+std::unique_ptr<World> makeSnapshotWorld(std::size_t entities) {
+    auto w    = makeWorld();
+    auto ents = createEntities(*w, entities);
+    populate(*w, ents);
+    for (std::size_t i = 0; i < ents.size(); i += 10) {
+        w->destroy(ents[i]);
+    }
+    w->flush();
+    return w;
+}
+
+template<std::size_t... I>
+void markChanged(World& w, std::size_t count, std::index_sequence<I...>) {
+    ((I < count ? w.storage<Value<I>>().markChanged() : void()), ...);
+}
+
+// buffers are warmed up by a round of snapshots, so the steady state is measured. A frame between the snapshots
+// moves the entities, so one storage is copied, all of them if every storage is written, or none of them
+template<std::size_t Changed>
+Sample worldSnapshot(const Params& params) {
+    auto w = makeSnapshotWorld(params.entities);
+    w->advanceTick();
+    for (std::size_t i = 0; i < detail::world::SNAPSHOTS; ++i) {
+        std::ignore = w->snapshot();
+    }
+    w->advanceTick();
+    markChanged(*w, Changed, std::make_index_sequence<MAX_COMPONENTS>{});
+
+    spdlog::stopwatch               sw;
+    [[maybe_unused]] SnapshotHandle handle  = w->snapshot();
+    auto                            seconds = sw.elapsed().count();
+    assert(handle != INVALID_SNAPSHOT && "World is not copyable");
+    return {seconds, params.entities};
+}
+
+// the world moves on before it's rolled back: entities are created, or only moved
+template<bool Create>
+Sample worldRestore(const Params& params) {
+    auto w = makeSnapshotWorld(params.entities);
+    w->advanceTick();
+    for (std::size_t i = 0; i < detail::world::SNAPSHOTS; ++i) {
+        std::ignore = w->snapshot();
+    }
+    auto handle = w->snapshot();
+    w->advanceTick();
+
+    if constexpr (Create) {
+        std::vector<Entity> created(params.entities / 10);
+        w->create(created);
+        populate(*w, created);
+    } else {
+        markChanged(*w, 1, std::make_index_sequence<MAX_COMPONENTS>{});
+    }
+
+    spdlog::stopwatch     sw;
+    [[maybe_unused]] bool ok      = w->restore(handle);
+    auto                  seconds = sw.elapsed().count();
+    assert(ok && "Snapshot is not restored");
+    return {seconds, params.entities};
+}
+
+constexpr std::array BENCHMARKS = {
+  Benchmark{"world.create", false, false, false, &worldCreate},
+  Benchmark{"world.create_batch", false, false, false, &worldCreateBatch},
+  Benchmark{"world.destroy_flush", true, false, false, &worldDestroy},
+  Benchmark{"world.snapshot", false, false, false, &worldSnapshot<1>},
+  Benchmark{"world.snapshot_idle", false, false, false, &worldSnapshot<0>},
+  Benchmark{"world.snapshot_full", false, false, false, &worldSnapshot<MAX_COMPONENTS>},
+  Benchmark{"world.restore", false, false, false, &worldRestore<true>},
+  Benchmark{"world.restore_moved", false, false, false, &worldRestore<false>},
+  Benchmark{"storage.emplace", true, false, false, &storageEmplace},
+  Benchmark{"storage.erase", true, false, false, &storageErase},
+  Benchmark{"storage.mark_changed", false, false, false, &storageMark<true>},
+  Benchmark{"storage.mark_updated", false, false, false, &storageMark<false>},
+  Benchmark{"filter.and", true, false, false, &filterEntities},
+  Benchmark{"observer.iterate", false, false, false, &observerIterate<&iterate>},
+  Benchmark{"observer.get_tuple", false, false, false, &observerIterate<&iterateTuple>},
+  Benchmark{"frame", false, true, true, &frame},
+  Benchmark{"serializer.save", false, false, false, &serializerSave},
+  Benchmark{"serializer.load", false, false, false, &serializerLoad},
+};
+
+
+template<typename T>
+std::vector<T> parseList(std::string_view str) {
+    std::vector<T> result;
+    while (!str.empty()) {
+        auto comma = str.find(',');
+        auto item  = str.substr(0, comma);
+        if constexpr (std::is_floating_point_v<T>) {
+            result.emplace_back(std::strtod(std::string(item).c_str(), nullptr));
+        } else {
+            T value{};
+            std::from_chars(item.data(), item.data() + item.size(), value);
+            result.emplace_back(value);
+        }
+        str = comma == std::string_view::npos ? std::string_view{} : str.substr(comma + 1);
+    }
+    return result;
+}
+
+bool parse(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string_view key   = argv[i];
+        std::string_view value = argv[i + 1];
+
+        if (key == "--entities") {
+            options.entities = parseList<std::size_t>(value);
+        } else if (key == "--components") {
+            options.components = parseList<std::size_t>(value);
+        } else if (key == "--churn") {
+            options.churn = parseList<double>(value);
+        } else if (key == "--threads") {
+            options.threads = parseList<std::size_t>(value);
+        } else if (key == "--repeats") {
+            options.repeats = std::max<std::size_t>(parseList<std::size_t>(value).front(), 1);
+        } else if (key == "--filter") {
+            options.filter = value;
+        } else if (key == "--format") {
+            options.format = value;
+        } else if (key == "--out") {
+            options.out = value;
+        } else {
+            spdlog::error("Unknown option {}", key);
+            return false;
+        }
+    }
+
+    std::erase_if(options.components, [](std::size_t count) { return count == 0 || count > MAX_COMPONENTS; });
+    std::erase_if(options.threads, [](std::size_t count) { return count == 0; });
+    options.threads.erase(std::ranges::unique(options.threads).begin(), options.threads.end());
+    return !options.entities.empty() && !options.components.empty() && !options.churn.empty() &&
+           !options.threads.empty();
+}
+
+Result measure(const Benchmark& benchmark, const Params& params, std::size_t repeats) {
+    std::vector<double> seconds;
+    Result              result{benchmark.name, params};
+
+    // keep the report clean, e.g. serializer logs its timings
+    const auto level = spdlog::get_level();
+    spdlog::set_level(spdlog::level::warn);
+    for (std::size_t i = 0; i < repeats; ++i) {
+        auto sample = benchmark.run(params);
+        seconds.emplace_back(sample.seconds);
+        result.ops = sample.ops;
+    }
+    spdlog::set_level(level);
+
+    std::ranges::sort(seconds);
+    result.best   = seconds.front();
+    result.median = seconds[seconds.size() / 2];
+    return result;
+}
+
+double nsPerOp(const Result& result) {
+    return result.ops ? result.best * 1e9 / static_cast<double>(result.ops) : 0.;
+}
+
+std::string json(const std::vector<Result>& results, const Options& options) {
+    std::string out;
+    auto        it = std::back_inserter(out);
+    fmt::format_to(it, R"({{"final":{},"repeats":{},"results":[)", ECS_FINAL_SWITCH(true, false), options.repeats);
+    for (const auto& result : results) {
+        fmt::format_to(it,
+                       R"({}{{"name":"{}","entities":{},"components":{},"churn":{},"threads":{},"ops":{},)"
+                       R"("best_ns":{:.0f},"median_ns":{:.0f},"ns_per_op":{:.3f}}})",
+                       &result == &results.front() ? "" : ",",
+                       result.name,
+                       result.params.entities,
+                       result.params.components,
+                       result.params.churn,
+                       result.params.threads,
+                       result.ops,
+                       result.best * 1e9,
+                       result.median * 1e9,
+                       nsPerOp(result));
+    }
+    out += "]}\n";
+    return out;
+}
+
+std::string csv(const std::vector<Result>& results) {
+    std::string out = "name,entities,components,churn,threads,ops,best_ns,median_ns,ns_per_op\n";
+    auto        it  = std::back_inserter(out);
+    for (const auto& result : results) {
+        fmt::format_to(it,
+                       "{},{},{},{},{},{},{:.0f},{:.0f},{:.3f}\n",
+                       result.name,
+                       result.params.entities,
+                       result.params.components,
+                       result.params.churn,
+                       result.params.threads,
+                       result.ops,
+                       result.best * 1e9,
+                       result.median * 1e9,
+                       nsPerOp(result));
+    }
+    return out;
+}
+
+void text(const Result& result) {
+    spdlog::info("{:<22} {:>10} {:>4} {:>6} {:>4} {:>14.3f} {:>14.3f} {:>12.2f}",
+                 result.name,
+                 result.params.entities,
+                 result.params.components,
+                 result.params.churn,
+                 result.params.threads,
+                 result.best * 1e3,
+                 result.median * 1e3,
+                 nsPerOp(result));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse(argc, argv, options)) {
+        spdlog::error("usage: SimpleECS_bench [--entities N,...] [--components 1..8,...] [--churn share,...] "
+                      "[--threads N,...] [--repeats N] [--filter name] [--format text|json|csv] [--out file]");
+        return 1;
+    }
+
+    const bool is_text = options.format == "text";
+    if (is_text) {
+        spdlog::info("best of {} runs", options.repeats);
+        spdlog::info("{:<22} {:>10} {:>4} {:>6} {:>4} {:>14} {:>14} {:>12}",
+                     "benchmark",
+                     "entities",
+                     "comp",
+                     "churn",
+                     "thr",
+                     "best ms",
+                     "median ms",
+                     "ns/op");
+    }
+
+    const auto job_threads      = JobScheduler::thread_count;
+    const auto observer_threads = ObserverManager::thread_count;
+
+    std::vector<Result> results;
+    for (const auto& benchmark : BENCHMARKS) {
+        if (benchmark.name.find(options.filter) == std::string_view::npos) {
+            continue;
+        }
+
+        // parameters which the benchmark doesn't depend on are taken once and reported as zero
+        auto components = benchmark.by_components ? options.components : std::vector<std::size_t>{0};
+        auto churn      = benchmark.by_churn ? options.churn : std::vector<double>{0.};
+        auto threads    = benchmark.by_threads ? options.threads : std::vector<std::size_t>{0};
+
+        for (auto entities : options.entities) {
+            for (auto component : components) {
+                for (auto share : churn) {
+                    for (auto thread : threads) {
+                        results.emplace_back(measure(benchmark, {entities, component, share, thread}, options.repeats));
+                        JobScheduler::thread_count    = job_threads;
+                        ObserverManager::thread_count = observer_threads;
+                        if (is_text) {
+                            text(results.back());
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (is_text) {
+        return 0;
+    }
+
+    auto report = options.format == "csv" ? csv(results) : json(results, options);
+    if (options.out.empty()) {
+        fmt::print("{}", report);
+        return 0;
+    }
+
+    std::ofstream file{std::string(options.out), std::ios::binary | std::ios::trunc};
+    if (!file.write(report.data(), static_cast<std::streamsize>(report.size()))) {
+        spdlog::error("Cannot write {}", options.out);
+        return 1;
+    }
+    return 0;
+}
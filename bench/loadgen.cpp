@@ -0,0 +1,373 @@
+#include "battle_system.h"
+#include "components.h"
+#include "hp_system.h"
+#include <simple-ecs/ECS.h>
+#include <simple-ecs/tools/histogram.h>
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Headless battle of the example at scale: BattleSystem and HPSystem plus generated systems, entities of a few
+// archetypes are replaced every frame. Reports frame time percentiles, it's the whole frame throughput benchmark.
+// usage: SimpleECS_loadgen [--entities 100000] [--archetypes 8] [--churn 0.01] [--systems 8] [--complexity 2]
+//                          [--frames 1000] [--threads 8] [--seed 1] [--format text|json] [--out file]
+
+namespace {
+
+constexpr std::size_t TRAITS      = 8;
+constexpr std::size_t MAX_SYSTEMS = 16;
+
+template<std::size_t I>
+struct Trait {
+    float value = 0.F;
+};
+
+// filter of the generated system: `Complexity` traits in a row starting from the system index, alive only
+template<std::size_t System, std::size_t Complexity>
+struct WorkFilterImpl {
+    template<std::size_t... I>
+    static auto require(std::index_sequence<I...>) -> Require<HP, Trait<(System + I) % TRAITS>...>;
+
+    using Type = Filter<decltype(require(std::make_index_sequence<Complexity>{})), Exclude<Dead>>;
+};
+
+template<std::size_t System, std::size_t Complexity>
+using WorkFilter = typename WorkFilterImpl<System, Complexity>::Type;
+
+template<std::size_t System, std::size_t Complexity>
+void work(const Observer<WorkFilter<System, Complexity>>& observer) {
+    for (auto e : observer) {
+        auto& trait = e.template get<Trait<System % TRAITS>>();
+        trait.value = trait.value * 0.5F + static_cast<float>(e.template get<const HP>().hp);
+    }
+}
+
+// function names are the ids, so every generated system gets its own one
+#define ECS_LOADGEN_SYSTEM(N)                                                                                     \
+    template<std::size_t Complexity>                                                                              \
+    void work##N(const Observer<WorkFilter<N, Complexity>>& observer) {                                           \
+        work<N, Complexity>(observer);                                                                            \
+    }
+
+ECS_LOADGEN_SYSTEM(0)
+ECS_LOADGEN_SYSTEM(1)
+ECS_LOADGEN_SYSTEM(2)
+ECS_LOADGEN_SYSTEM(3)
+ECS_LOADGEN_SYSTEM(4)
+ECS_LOADGEN_SYSTEM(5)
+ECS_LOADGEN_SYSTEM(6)
+ECS_LOADGEN_SYSTEM(7)
+ECS_LOADGEN_SYSTEM(8)
+ECS_LOADGEN_SYSTEM(9)
+ECS_LOADGEN_SYSTEM(10)
+ECS_LOADGEN_SYSTEM(11)
+ECS_LOADGEN_SYSTEM(12)
+ECS_LOADGEN_SYSTEM(13)
+ECS_LOADGEN_SYSTEM(14)
+ECS_LOADGEN_SYSTEM(15)
+
+template<std::size_t Complexity>
+void registerSystems(Registry& reg, std::size_t count) {
+    // clang-format off
+    switch (count) {
+        default:
+        case 16: ECS_REG_EXTERN_FUNC(reg, work15<Complexity>); [[fallthrough]];
+        case 15: ECS_REG_EXTERN_FUNC(reg, work14<Complexity>); [[fallthrough]];
+        case 14: ECS_REG_EXTERN_FUNC(reg, work13<Complexity>); [[fallthrough]];
+        case 13: ECS_REG_EXTERN_FUNC(reg, work12<Complexity>); [[fallthrough]];
+        case 12: ECS_REG_EXTERN_FUNC(reg, work11<Complexity>); [[fallthrough]];
+        case 11: ECS_REG_EXTERN_FUNC(reg, work10<Complexity>); [[fallthrough]];
+        case 10: ECS_REG_EXTERN_FUNC(reg, work9<Complexity>); [[fallthrough]];
+        case 9: ECS_REG_EXTERN_FUNC(reg, work8<Complexity>); [[fallthrough]];
+        case 8: ECS_REG_EXTERN_FUNC(reg, work7<Complexity>); [[fallthrough]];
+        case 7: ECS_REG_EXTERN_FUNC(reg, work6<Complexity>); [[fallthrough]];
+        case 6: ECS_REG_EXTERN_FUNC(reg, work5<Complexity>); [[fallthrough]];
+        case 5: ECS_REG_EXTERN_FUNC(reg, work4<Complexity>); [[fallthrough]];
+        case 4: ECS_REG_EXTERN_FUNC(reg, work3<Complexity>); [[fallthrough]];
+        case 3: ECS_REG_EXTERN_FUNC(reg, work2<Complexity>); [[fallthrough]];
+        case 2: ECS_REG_EXTERN_FUNC(reg, work1<Complexity>); [[fallthrough]];
+        case 1: ECS_REG_EXTERN_FUNC(reg, work0<Complexity>); [[fallthrough]];
+        case 0: break;
+    }
+    // clang-format on
+}
+
+
+struct Options {
+    std::size_t      entities   = 100'000;
+    std::size_t      archetypes = 8; // players with a different set of traits
+    double           churn      = 0.01;
+    std::size_t      systems    = 8;
+    std::size_t      complexity = 2; // traits required by every generated system
+    std::size_t      frames     = 1000;
+    std::size_t      threads    = std::max(1U, std::thread::hardware_concurrency());
+    std::uint64_t    seed       = 1;
+    std::string_view format     = "text";
+    std::string_view out;
+};
+
+struct Report {
+    Histogram   frame_time; // ns
+    double      seconds   = 0.;
+    std::size_t created   = 0;
+    std::size_t destroyed = 0;
+};
+
+
+// archetype k has 4 traits in a row starting from k % TRAITS, the higher bits of k change the set.
+// A generated filter of c traits matches 5 - c of the first 8 archetypes
+std::size_t traits(std::size_t archetype) {
+    auto shift  = archetype % TRAITS;
+    auto window = (0x0FU << shift) | (0x0FU >> (TRAITS - shift));
+    return (window ^ (archetype / TRAITS)) & 0xFFU;
+}
+
+template<std::size_t... I>
+void emplaceTraits(World& w, Entity e, std::size_t archetype, std::index_sequence<I...>) {
+    const auto mask = traits(archetype);
+    ((mask & (std::size_t{1} << I) ? w.emplace<Trait<I>>(e, Trait<I>{}) : void()), ...);
+}
+
+struct Battle {
+    Battle(const Options& options) : m_options(options), m_random(options.seed) {
+        ComponentRegistrant<Dead, Player, Boss>(m_world).createStorage();
+        ComponentRegistrant<Damage, HP>(m_world).createStorage();
+        [this]<std::size_t... I>(std::index_sequence<I...>) {
+            ComponentRegistrant<Trait<I>...>(m_world).createStorage();
+        }(std::make_index_sequence<TRAITS>{});
+
+        auto& reg = *m_world.getRegistry();
+        reg.addSystem<HPSystem>();
+        reg.addSystem<BattleSystem>();
+        switch (std::clamp<std::size_t>(options.complexity, 1, 4)) {
+            case 1: registerSystems<1>(reg, options.systems); break;
+            case 2: registerSystems<2>(reg, options.systems); break;
+            case 3: registerSystems<3>(reg, options.systems); break;
+            default: registerSystems<4>(reg, options.systems); break;
+        }
+        reg.initNewSystems();
+
+        // ids of the players killed by HPSystem are reused by the next spawns, so their slots are released
+        m_world.subscribeDestroy([this](std::span<const Entity> destroyed) {
+            for (auto e : destroyed) {
+                if (e < m_slots.size()) {
+                    m_slots[e] = NO_SLOT;
+                }
+            }
+        });
+
+        m_players.resize(options.entities);
+        for (std::size_t i = 0; i < options.entities; ++i) {
+            spawn(i);
+        }
+        respawnBoss();
+    }
+
+    Report run() {
+        auto& reg = *m_world.getRegistry();
+
+        // the first frame refreshes all observers
+        reg.prepare();
+        reg.exec();
+
+        Report report;
+        const auto churn = static_cast<std::size_t>(m_options.churn * static_cast<double>(m_players.size()));
+
+        spdlog::stopwatch total;
+        for (std::size_t frame = 0; frame < m_options.frames; ++frame) {
+            spdlog::stopwatch sw;
+
+            // players are replaced in turn, the dead ones were destroyed by HPSystem already
+            for (std::size_t i = 0; i < churn; ++i) {
+                if (auto player = m_players[m_oldest]; m_slots[player] == m_oldest) {
+                    m_world.destroy(player);
+                    report.destroyed++;
+                }
+                m_oldest = (m_oldest + 1) % m_players.size();
+            }
+            for (std::size_t i = 0; i < churn; ++i) {
+                spawn((m_oldest + m_players.size() - churn + i) % m_players.size());
+            }
+            report.created += churn;
+            respawnBoss();
+
+            reg.prepare();
+            reg.exec();
+
+            report.frame_time.record(static_cast<std::uint64_t>(sw.elapsed().count() * 1e9));
+        }
+        report.seconds = total.elapsed().count();
+
+        return report;
+    }
+
+private:
+    void spawn(std::size_t slot) {
+        Entity e = m_spawner.create(PlayerType{});
+        emplaceTraits(m_world, e, m_random() % m_options.archetypes, std::make_index_sequence<TRAITS>{});
+
+        if (e >= m_slots.size()) {
+            m_slots.resize(e + 1, NO_SLOT);
+        }
+        m_slots[e]      = slot;
+        m_players[slot] = e;
+    }
+
+    void respawnBoss() {
+        if (m_world.empty<Boss>()) {
+            std::ignore = m_spawner.create(BossType{});
+        }
+    }
+
+private:
+    static constexpr std::size_t NO_SLOT = std::numeric_limits<std::size_t>::max();
+
+    const Options&           m_options;
+    World                    m_world;
+    Observer<>               m_spawner{m_world};
+    std::mt19937_64          m_random;
+    std::vector<Entity>      m_players; // by slot, the slot is stale when `m_slots` of the entity doesn't point to it
+    std::vector<std::size_t> m_slots;   // slot of the alive player by entity id
+    std::size_t              m_oldest = 0;
+};
+
+
+std::size_t parseSize(std::string_view str) {
+    std::size_t value = 0;
+    std::from_chars(str.data(), str.data() + str.size(), value);
+    return value;
+}
+
+bool parse(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string_view key   = argv[i];
+        std::string_view value = argv[i + 1];
+
+        if (key == "--entities") {
+            options.entities = parseSize(value);
+        } else if (key == "--archetypes") {
+            options.archetypes = std::clamp<std::size_t>(parseSize(value), 1, TRAITS << TRAITS);
+        } else if (key == "--churn") {
+            options.churn = std::clamp(std::strtod(std::string(value).c_str(), nullptr), 0., 1.);
+        } else if (key == "--systems") {
+            options.systems = std::min(parseSize(value), MAX_SYSTEMS);
+        } else if (key == "--complexity") {
+            options.complexity = std::clamp<std::size_t>(parseSize(value), 1, 4);
+        } else if (key == "--frames") {
+            options.frames = parseSize(value);
+        } else if (key == "--threads") {
+            options.threads = std::max<std::size_t>(parseSize(value), 1);
+        } else if (key == "--seed") {
+            options.seed = parseSize(value);
+        } else if (key == "--format") {
+            options.format = value;
+        } else if (key == "--out") {
+            options.out = value;
+        } else {
+            spdlog::error("Unknown option {}", key);
+            return false;
+        }
+    }
+    return options.entities > 0 && options.frames > 0;
+}
+
+std::string json(const Options& options, const Report& report) {
+    const auto& time = report.frame_time;
+    return fmt::format(R"({{"final":{},"entities":{},"archetypes":{},"churn":{},"systems":{},"complexity":{},)"
+                       R"("threads":{},"frames":{},"seconds":{:.3f},"created":{},"destroyed":{},)"
+                       R"("frame_time_ns":{{"min":{},"mean":{:.1f},"p50":{},"p90":{},"p99":{},"p999":{},"max":{}}}}})"
+                       "\n",
+                       ECS_FINAL_SWITCH(true, false),
+                       options.entities,
+                       options.archetypes,
+                       options.churn,
+                       options.systems,
+                       options.complexity,
+                       options.threads,
+                       options.frames,
+                       report.seconds,
+                       report.created,
+                       report.destroyed,
+                       time.min(),
+                       time.mean(),
+                       time.percentile(50.),
+                       time.percentile(90.),
+                       time.percentile(99.),
+                       time.percentile(99.9),
+                       time.max());
+}
+
+void text(const Options& options, const Report& report) {
+    const auto& time = report.frame_time;
+    constexpr double MS = 1e6;
+
+    spdlog::info("{} entities, {} archetypes, churn {}, {} systems of {} traits, {} threads",
+                 options.entities,
+                 options.archetypes,
+                 options.churn,
+                 options.systems,
+                 options.complexity,
+                 options.threads);
+    spdlog::info("{} frames in {:.3f} s, {:.1f} frames/s, {} created, {} destroyed",
+                 options.frames,
+                 report.seconds,
+                 static_cast<double>(options.frames) / report.seconds,
+                 report.created,
+                 report.destroyed);
+    spdlog::info("frame ms: mean {:.3f} p50 {:.3f} p90 {:.3f} p99 {:.3f} p99.9 {:.3f} max {:.3f}",
+                 time.mean() / MS,
+                 static_cast<double>(time.percentile(50.)) / MS,
+                 static_cast<double>(time.percentile(90.)) / MS,
+                 static_cast<double>(time.percentile(99.)) / MS,
+                 static_cast<double>(time.percentile(99.9)) / MS,
+                 static_cast<double>(time.max()) / MS);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse(argc, argv, options)) {
+        spdlog::error("usage: SimpleECS_loadgen [--entities N] [--archetypes N] [--churn share] [--systems 0..16] "
+                      "[--complexity 1..4] [--frames N] [--threads N] [--seed N] [--format text|json] [--out file]");
+        return 1;
+    }
+
+    JobScheduler::thread_count    = options.threads;
+    ObserverManager::thread_count = options.threads;
+
+    // the example systems log every hit and death
+    const auto level = spdlog::get_level();
+    spdlog::set_level(spdlog::level::err);
+
+    Report report;
+    {
+        Battle battle(options);
+        report = battle.run();
+    }
+    spdlog::set_level(level);
+
+    if (options.format != "json") {
+        text(options, report);
+        return 0;
+    }
+
+    auto result = json(options, report);
+    if (options.out.empty()) {
+        fmt::print("{}", result);
+        return 0;
+    }
+
+    std::ofstream file{std::string(options.out), std::ios::binary | std::ios::trunc};
+    if (!file.write(result.data(), static_cast<std::streamsize>(result.size()))) {
+        spdlog::error("Cannot write {}", options.out);
+        return 1;
+    }
+    return 0;
+}
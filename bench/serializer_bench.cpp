@@ -0,0 +1,107 @@
+#include <simple-ecs/ECS.h>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <string_view>
+
+// Save and load throughput and size of a snapshot with and without compression.
+// usage: SimpleECS_serializer_bench [entities] [repeats]
+
+namespace {
+
+struct Transform {
+    float x, y, z;
+    float yaw;
+};
+
+struct Health {
+    int hp;
+    int max;
+};
+
+struct Frozen {};
+
+struct Result {
+    std::size_t bytes = 0;
+    double      save  = std::numeric_limits<double>::max(); // best of the repeats, seconds
+    double      load  = std::numeric_limits<double>::max();
+};
+
+std::size_t parse(const char* arg, std::size_t fallback) {
+    std::size_t      value = fallback;
+    std::string_view str   = arg;
+    std::from_chars(str.data(), str.data() + str.size(), value);
+    return value;
+}
+
+void populate(World& w, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        auto e = w.create();
+        auto f = static_cast<float>(i);
+        w.emplace<Transform>(e, Transform{f, f * 0.5F, 0.F, static_cast<float>(i % 360)});
+        if (i % 2 == 0) {
+            w.emplace<Health>(e, Health{static_cast<int>(i % 100), 100});
+        }
+        if (i % 8 == 0) {
+            w.emplace<Frozen>(e);
+        }
+        if (i % 16 == 0) {
+            w.emplace<Name>(e, Name{"Unit " + std::to_string(i % 1000)});
+        }
+    }
+}
+
+Result run(World& w, Serializer& serializer, serializer::Codec codec, std::size_t repeats) {
+    Result result;
+    serializer.setCompression(codec);
+
+    for (std::size_t i = 0; i < repeats; ++i) {
+        spdlog::stopwatch save_time;
+        auto              data = serializer.save();
+        result.save            = std::min(result.save, save_time.elapsed().count());
+        result.bytes           = data.size();
+
+        w.destroy(std::span<const Entity>(w.entities()));
+        w.flush();
+
+        spdlog::stopwatch load_time;
+        [[maybe_unused]] bool ok = serializer.load(data);
+        result.load              = std::min(result.load, load_time.elapsed().count());
+        assert(ok && "Snapshot is not loaded");
+    }
+
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto count   = argc > 1 ? parse(argv[1], 1'000'000) : 1'000'000;
+    auto repeats = std::max<std::size_t>(argc > 2 ? parse(argv[2], 5) : 5, 1);
+
+    World w;
+    ComponentRegistrant<Transform, Health, Frozen>(w).createStorage().addSerialize();
+
+    auto* reg = w.getRegistry();
+    reg->initNewSystems();
+    populate(w, count);
+
+    spdlog::info("{} entities, best of {} runs", count, repeats);
+    spdlog::info("{:>6} {:>12} {:>8} {:>12} {:>12}", "codec", "bytes", "ratio", "save MB/s", "load MB/s");
+
+    std::size_t raw_bytes = 0;
+    for (auto [codec, name] : {std::pair{serializer::Codec::None, "none"}, std::pair{serializer::Codec::LZ, "lz"}}) {
+        auto result = run(w, reg->serializer(), codec, repeats);
+        raw_bytes   = raw_bytes ? raw_bytes : result.bytes;
+
+        constexpr double MB = 1024. * 1024.;
+        spdlog::info("{:>6} {:>12} {:>8.3f} {:>12.1f} {:>12.1f}",
+                     name,
+                     result.bytes,
+                     static_cast<double>(raw_bytes) / static_cast<double>(result.bytes),
+                     static_cast<double>(raw_bytes) / MB / result.save,
+                     static_cast<double>(raw_bytes) / MB / result.load);
+    }
+
+    return 0;
+}
@@ -19,7 +19,7 @@ void BattleSystem::hitBoss(OBSERVER(PlayerFilter) players, OBSERVER(BossFilter)
 
     const auto& first_boss = *boss.begin();
     auto&       boss_hp    = first_boss.get<HP>();
-    auto&       boss_name  = first_boss.get<Name>();
+    auto&       boss_name  = first_boss.get<const Name>();
 
     for (const auto& e : players) {
         const auto& [name, hp, damage] = e.get();
@@ -47,7 +47,7 @@ void BattleSystem::hitPlayers(OBSERVER(PlayerFilter) players, OBSERVER(BossFilte
         const auto& random_player = dice<size_t>(0, players.size() - 1);
         const auto& player        = players[random_player];
         auto&       player_hp     = player.get<HP>();
-        auto&       player_name   = player.get<Name>();
+        auto&       player_name   = player.get<const Name>();
         if (dice(0, 1)) { // 50% hit
             spdlog::info("{} hit {} HP {} (-{})", name.name, player_name.name, player_hp.hp, damage.damage);
             player_hp.hp -= damage.damage;
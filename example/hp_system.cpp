@@ -17,7 +17,7 @@ void HPSystem::stop(Registry& reg) {
 
 void HPSystem::checkHP(OBSERVER(CheckHPFilter) observer) {
     for (auto e : observer) {
-        const auto& hp = e.get<HP>();
+        const auto& hp = e.get<const HP>();
 
         if (hp.hp <= 0) {
             e.emplace<Dead>();
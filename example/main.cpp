@@ -24,7 +24,7 @@ int main() {
       .addDestroyCallback([](Entity e) { spdlog::debug("Entity {} with Tag {} was removed", e, ct::NAME<Player>); });
 
     ComponentRegistrant<HP>(w).addDestroyCallback([&w](Entity e, HP& c) {
-        const auto& name = w.get<Name>(e);
+        const auto& name = w.get<const Name>(e);
         spdlog::debug("Entity '{}', Name '{}' with HP '{}' was removed", e, name.name, c.hp);
         c.hp = 0; // do something with component before destroy
     });
@@ -39,9 +39,22 @@ struct Archetype : Component... {
 };
 
 
+// tag kept until `clearUpdateTag`. Its storage is created by the first `markUpdated` of the component or a filter
+// with `Updated`, so components which are never tagged don't pay for it
 template<typename Component>
 struct Updated {};
 
+template<typename Component>
+inline constexpr bool IS_UPDATED = false;
+
+template<typename Component>
+inline constexpr bool IS_UPDATED<Updated<Component>> = true;
+
+// filter only: matches the entities whose Component was emplaced or marked as changed since the previous refresh of
+// the observer, i.e. since the functions using the observer were run
+template<typename Component>
+struct Changed {};
+
 
 template<typename Component>
 struct RemoveTag {
@@ -53,6 +66,11 @@ struct RemoveTag<Updated<Component>> {
     using Type = Component;
 };
 
+template<typename Component>
+struct RemoveTag<Changed<Component>> {
+    using Type = Component;
+};
+
 template<typename Component>
 using RemoveTag_t = typename RemoveTag<Component>::Type;
 
@@ -21,32 +21,18 @@ void EntityDebugSystem::setup([[maybe_unused]] Registry& reg) {
       .addCreateFunc()
       .addEmplaceCallback([](Entity e, Name& c) { spdlog::debug("Entity {} ({}) was created", c.name.c_str(), e); })
       .addDestroyCallback([](Entity e, Name& c) { spdlog::debug("Entity {} ({}) was removed", c.name.c_str(), e); })
-      .setSaveFunc([](const Name& comp) {
-          serializer::Output temp;
-          auto&&             size = serializer::serialize(comp.name.size());
-          std::ranges::copy(size, std::back_inserter(temp));
-          std::ranges::copy(comp.name, std::back_inserter(temp));
-          return temp;
-      })
-      .setLoadFunc([](serializer::Input& data) -> Name {
-          auto&&      size = serializer::deserialize<std::string::size_type>(data);
-          std::string temp(size, 0);
-          std::memcpy(temp.data(), data, size);
-          data += size;
-          return {std::move(temp)};
-      });
+      .setSaveFunc([](const Name& comp, serializer::OutputView& out) { out.writeString(comp.name); })
+      .setLoadFunc([](serializer::InputView& in) -> Name { return {std::string(in.readString())}; });
 }
 
 void EntityDebugSystem::trackEntitiesCount(OBSERVER(RunEveryFrame) /*unused*/) {
     ECS_PROFILER(ZoneScoped);
 
 #ifdef ECS_ENABLE_IMGUI
-    static float time_tick = 0;
-
-    time_tick += ImGui::GetIO().DeltaTime;
-    if (time_tick > (1. / 60.)) {
-        m_time += time_tick;
-        time_tick = 0;
+    m_time_tick += ImGui::GetIO().DeltaTime;
+    if (m_time_tick > (1. / 60.)) {
+        m_time += m_time_tick;
+        m_time_tick = 0;
         m_entities_history.addPoint(m_time, m_world.size());
     }
 #endif
@@ -63,27 +49,41 @@ void EntityDebugSystem::showRegisteredComponents([[maybe_unused]] bool& show) {
     if (ImGui::Begin("Component list", &show, ImGuiWindowFlags_NoCollapse)) {
         constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
 
-        if (ImGui::BeginTable("components", 2, flags)) {
+        const auto report = m_world.memoryReport();
+        ImGui::Text("Memory %.1f / %.1f KB", report.used() / 1024., report.capacity() / 1024.);
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Log")) {
+            spdlog::info("\n{}", dumpMemoryReport(report));
+        }
+
+        if (ImGui::BeginTable("components", 4, flags)) {
             ImGui::TableSetupScrollFreeze(0, 1); // Make top row always visible
             ImGui::TableSetupColumn("Name");
             ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_WidthFixed, 0.0f);
+            ImGui::TableSetupColumn("Memory, KB", ImGuiTableColumnFlags_WidthFixed, 0.0f);
+            ImGui::TableSetupColumn("Unused", ImGuiTableColumnFlags_WidthFixed, 0.0f);
             ImGui::TableHeadersRow();
 
             ImGuiListClipper clipper;
-            const auto&      components = m_world.registeredComponentNames();
+            const auto&      components = report.components; // in the order of registeredComponentNames()
             clipper.Begin(components.size());
 
             while (clipper.Step()) {
                 for (int row_n = clipper.DisplayStart; row_n < clipper.DisplayEnd; row_n++) {
-                    auto it = components.begin();
-                    std::advance(it, row_n);
-                    const auto& [name, id] = *it;
+                    const auto& component = components[row_n];
                     ImGui::TableNextRow();
                     ImGui::TableNextColumn();
-                    ImGui::Text("%s", name.c_str());
+                    ImGui::Text("%.*s", static_cast<int>(component.name.size()), component.name.data());
 
                     ImGui::TableNextColumn();
-                    ImGui::Text("%08X", id);
+                    ImGui::Text("%08X", component.id);
+
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", component.capacity() / 1024.);
+
+                    ImGui::TableNextColumn();
+                    auto capacity = component.capacity();
+                    ImGui::Text("%.0f%%", capacity ? 100. * (capacity - component.used()) / capacity : 0.);
                 }
             }
             ImGui::EndTable();
@@ -141,8 +141,6 @@ void EntityDebugSystem::showEntityListUI([[maybe_unused]] bool& show) {
     ECS_PROFILER(ZoneScoped);
 
 #ifdef ECS_ENABLE_IMGUI
-    static std::unordered_map<Entity, std::function<bool(void)>> show_entity_info;
-
     if (!show) {
         return;
     }
@@ -179,7 +177,7 @@ void EntityDebugSystem::showEntityListUI([[maybe_unused]] bool& show) {
 
                     ImGui::TableNextColumn();
                     auto ent_name = ""_t;
-                    if (auto* name = m_world.tryGet<Name>(e)) {
+                    if (auto* name = m_world.tryGet<const Name>(e)) {
                         *ent_name = std::format("{} ({})", name->name, e);
                     } else {
                         *ent_name = std::format("Entity: {}", e);
@@ -192,7 +190,7 @@ void EntityDebugSystem::showEntityListUI([[maybe_unused]] bool& show) {
 
                     ImGui::TableNextColumn();
                     if (ImGui::SmallButton("View")) {
-                        show_entity_info.emplace(e, std::bind_front(&EntityDebugSystem::showEntityInfoUI, this, e));
+                        m_show_entity_info.emplace(e, std::bind_front(&EntityDebugSystem::showEntityInfoUI, this, e));
                     }
 
                     ImGui::TableNextColumn();
@@ -207,8 +205,8 @@ void EntityDebugSystem::showEntityListUI([[maybe_unused]] bool& show) {
         }
 
         // show info for selected entity
-        for (auto it = show_entity_info.begin(); it != show_entity_info.end();) {
-            it = std::invoke(it->second) ? show_entity_info.erase(it) : ++it;
+        for (auto it = m_show_entity_info.begin(); it != m_show_entity_info.end();) {
+            it = std::invoke(it->second) ? m_show_entity_info.erase(it) : ++it;
         }
 
 
@@ -216,7 +214,7 @@ void EntityDebugSystem::showEntityListUI([[maybe_unused]] bool& show) {
             entityHistory();
         }
     } else {
-        show_entity_info.clear();
+        m_show_entity_info.clear();
         m_show_entities_history = false;
     }
     ImGui::End();
@@ -230,7 +228,7 @@ bool EntityDebugSystem::showEntityInfoUI([[maybe_unused]] Entity e) {
 #ifdef ECS_ENABLE_IMGUI
     bool show = true;
 
-    auto*       name   = m_world.tryGet<Name>(e);
+    auto*       name   = m_world.tryGet<const Name>(e);
     std::string header = (name ? name->name : "Entity") + " (" + std::to_string(e) + ")";
 
     if (ImGui::Begin(header.c_str(), &show, ImGuiWindowFlags_NoCollapse)) {
@@ -269,13 +267,12 @@ void EntityDebugSystem::entityHistory() {
     }
 
     if (ImGui::Begin("Entity count", &m_show_entities_history, ImGuiWindowFlags_NoCollapse)) {
-        static float history = 60.0f;
         double       size    = m_world.size();
 
-        ImGui::SliderFloat("History", &history, 1, 600, "%.0f s");
+        ImGui::SliderFloat("History", &m_history, 1, 600, "%.0f s");
         if (ImPlot::BeginPlot("##Scrolling", ImVec2(-1, -1))) {
             ImPlot::SetupAxes(nullptr, nullptr, 0, ImPlotAxisFlags_Opposite | ImPlotAxisFlags_AutoFit);
-            ImPlot::SetupAxisLimits(ImAxis_X1, m_time - history, m_time, ImGuiCond_Always);
+            ImPlot::SetupAxisLimits(ImAxis_X1, m_time - m_history, m_time, ImGuiCond_Always);
             ImPlot::SetupAxisLimits(ImAxis_Y1, 0, size);
             ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.5f);
             ImPlot::PlotShaded("Entities",
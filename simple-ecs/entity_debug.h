@@ -108,7 +108,7 @@ struct EntityDebugSystem final : BaseSystem {
                 bool update = false;
                 debug<Component>(*c, e, update);
                 if (update) {
-                    world.emplace<Updated<Component>>(e);
+                    world.markUpdated<Component>(e);
                 }
 
                 ImGui::Separator();
@@ -144,7 +144,7 @@ struct EntityDebugSystem final : BaseSystem {
                   bool update = false;
                   callback(e, c, update);
                   if (update) {
-                      world.emplace<Updated<Component>>(e);
+                      world.markUpdated<Component>(e);
                   }
 
                   ImGui::Separator();
@@ -192,7 +192,10 @@ private:
     std::unordered_map<std::string, std::function<void(Entity)>> m_create_callbacks;
 
 #ifdef ECS_ENABLE_IMGUI
-    ScrollingBuffer m_entities_history;
+    ScrollingBuffer                                       m_entities_history;
+    std::unordered_map<Entity, std::function<bool(void)>> m_show_entity_info;
+    float                                                 m_time_tick = 0;
+    float                                                 m_history   = 60.0f;
 #endif
     float m_time                  = 0;
     bool  m_show_entities_history = false;
@@ -75,6 +75,11 @@ struct EntityWrapper final {
         m_observer.template markUpdated<Component...>(m_entity);
     }
 
+    template<typename... Component>
+    ECS_FORCEINLINE void markChanged() const {
+        m_observer.template markChanged<Component...>(m_entity);
+    }
+
     template<typename... Component>
     ECS_FORCEINLINE void clearUpdateTag() const {
         m_observer.template clearUpdateTag<Component...>(m_entity);
@@ -91,6 +96,12 @@ struct EntityWrapper final {
         return m_observer.template get<Component>(m_entity);
     }
 
+    template<typename Component>
+    requires(!std::is_empty_v<Component>)
+    [[nodiscard]] ECS_FORCEINLINE decltype(auto) getChanged() const noexcept {
+        return m_observer.template getChanged<Component>(m_entity);
+    }
+
     template<typename Component>
     requires(!std::is_empty_v<Component>)
     [[nodiscard]] ECS_FORCEINLINE decltype(auto) tryGet() const noexcept {
@@ -156,3 +156,84 @@ template<>
 struct FilteredEntities<OR<Components<>>> {
     ECS_FORCEINLINE static TmpBufferVector ents(const World& /*world*/) { return TMP_GET(std::vector<Entity>); }
 };
+
+
+// Changed<Component> is matched by the ticks of the Component storage, so the entities are taken from that storage
+template<typename...>
+struct RemoveChanged;
+
+template<typename Component>
+struct RemoveChanged<Component> {
+    using Type = Components<Component>;
+};
+
+template<typename Component>
+struct RemoveChanged<Changed<Component>> {
+    using Type = Components<Component>;
+};
+
+template<typename... Component>
+struct RemoveChanged<Components<Component...>> {
+    using Type = typename Components<typename RemoveChanged<Component>::Type...>::Type;
+};
+
+template<typename Components>
+using RemoveChanged_t = typename RemoveChanged<Components>::Type;
+
+
+template<typename...>
+struct OnlyChanged;
+
+template<typename Component>
+struct OnlyChanged<Component> {
+    using Type = Components<>;
+};
+
+template<typename Component>
+struct OnlyChanged<Changed<Component>> {
+    using Type = Components<Component>;
+};
+
+template<typename... Component>
+struct OnlyChanged<Components<Component...>> {
+    using Type = typename Components<typename OnlyChanged<Component>::Type...>::Type;
+};
+
+template<typename Components>
+using OnlyChanged_t = typename OnlyChanged<Components>::Type;
+
+
+template<typename...>
+struct ChangedEntities;
+
+// keeps the entities with all Components changed at `since` or later
+template<typename... Component>
+struct ChangedEntities<Components<Component...>> {
+    ECS_FORCEINLINE static void keep(const World& world, std::vector<Entity>& entities, Tick since) {
+        ECS_PROFILER(ZoneScoped);
+
+        if constexpr (sizeof...(Component) > 0) {
+            std::erase_if(entities, [&world, since](Entity e) {
+                return !(world.storage<Component>().changedSince(e, since) && ...);
+            });
+        }
+    }
+};
+
+
+template<typename...>
+struct TrackUpdates;
+
+// creates the storages of the `Updated<Component>` tags used by a filter
+template<typename... Component>
+struct TrackUpdates<Components<Component...>> {
+    static void create([[maybe_unused]] World& world) { (track<Component>(world), ...); }
+
+private:
+    template<typename T>
+    static void track(World& world) {
+        if constexpr (IS_UPDATED<T>) {
+            world.trackUpdates<RemoveTag_t<T>>();
+        }
+    }
+};
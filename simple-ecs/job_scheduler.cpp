@@ -0,0 +1,252 @@
+#include "simple-ecs/job_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+
+JobScheduler::JobScheduler() : m_start(Clock::now()) {}
+
+// threads are started by the first job, so registries which never run jobs don't keep idle threads
+void JobScheduler::start() {
+    m_threads.reserve(thread_count + 1);
+
+    m_threads.emplace_back([this](const std::stop_token& stoken) {
+        ECS_PROFILER(tracy::SetThreadName("ECS Timer Thread"));
+        timerLoop(stoken);
+    });
+
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        m_threads.emplace_back([this](const std::stop_token& stoken) {
+            ECS_PROFILER(tracy::SetThreadName("ECS Job Thread"));
+            workerLoop(stoken);
+        });
+    }
+}
+
+JobScheduler::~JobScheduler() {
+    ECS_PROFILER(ZoneScoped);
+
+    cancelAll();
+    for (auto& thread : m_threads) {
+        thread.request_stop();
+    }
+    m_threads.clear();
+}
+
+void JobScheduler::run(SystemID owner, Job&& job, Duration period) {
+    ECS_PROFILER(ZoneScoped);
+
+    assert(period >= RESOLUTION && "Period is less than the scheduler resolution");
+
+    auto task      = std::make_shared<Task>();
+    task->owner    = owner;
+    task->job      = std::move(job);
+    task->period   = period;
+    task->deadline = Clock::now() + period;
+
+    std::call_once(m_started, &JobScheduler::start, this);
+
+    std::lock_guard _(m_mutex);
+    m_tasks.emplace_back(task);
+    schedule(std::move(task));
+}
+
+void JobScheduler::post(std::function<void(void)>&& job) {
+    ECS_PROFILER(ZoneScoped);
+
+    auto task      = std::make_shared<Task>();
+    task->job      = [job = std::move(job)] {
+        job();
+        return false;
+    };
+    task->deadline = Clock::now();
+
+    std::call_once(m_started, &JobScheduler::start, this);
+
+    {
+        // kept with the periodic jobs, so cancelAll waits for the running ones
+        std::lock_guard _(m_mutex);
+        m_tasks.emplace_back(task);
+        m_ready.emplace_back(std::move(task));
+    }
+    m_ready_cv.notify_one();
+}
+
+void JobScheduler::cancel(SystemID owner) {
+    ECS_PROFILER(ZoneScoped);
+
+    std::unique_lock lock(m_mutex);
+
+    std::vector<TaskPtr> cancelled;
+    std::erase_if(m_tasks, [owner, &cancelled](const TaskPtr& task) {
+        if (task->owner != owner) {
+            return false;
+        }
+        task->cancelled = true;
+        cancelled.emplace_back(task);
+        return true;
+    });
+
+    m_done_cv.wait(lock, [&cancelled] {
+        return std::ranges::none_of(cancelled, [](const TaskPtr& task) { return task->running; });
+    });
+}
+
+void JobScheduler::parallel(std::span<const std::function<void(void)>> tasks) {
+    ECS_PROFILER(ZoneScoped);
+
+    struct State {
+        std::atomic_size_t next = 0;
+        std::atomic_size_t done = 0;
+    };
+
+    // late helpers find no tasks and don't touch them, but they still need the counters
+    auto state = std::make_shared<State>();
+    auto run   = [state, tasks] {
+        for (auto i = state->next++; i < tasks.size(); i = state->next++) {
+            tasks[i]();
+            if (++state->done == tasks.size()) {
+                state->done.notify_all();
+            }
+        }
+    };
+
+    for (std::size_t i = 1; i < std::min(tasks.size(), thread_count + 1); ++i) {
+        post(run);
+    }
+    run();
+
+    for (auto done = state->done.load(); done < tasks.size(); done = state->done.load()) {
+        state->done.wait(done);
+    }
+}
+
+void JobScheduler::cancelAll() {
+    ECS_PROFILER(ZoneScoped);
+
+    std::unique_lock lock(m_mutex);
+
+    auto cancelled = std::move(m_tasks);
+    m_tasks.clear();
+    for (auto& task : cancelled) {
+        task->cancelled = true;
+    }
+
+    m_done_cv.wait(lock, [&cancelled] {
+        return std::ranges::none_of(cancelled, [](const TaskPtr& task) { return task->running; });
+    });
+}
+
+std::vector<JobStats> JobScheduler::stats() const {
+    std::lock_guard _(m_mutex);
+
+    std::vector<JobStats> result;
+    result.reserve(m_tasks.size());
+    for (const auto& task : m_tasks) {
+        if (task->period == Duration::zero()) {
+            continue; // posted once
+        }
+
+        auto& stat       = result.emplace_back();
+        stat.owner       = task->owner;
+        stat.period      = task->period;
+        stat.runs        = task->runs;
+        stat.max_jitter  = task->jitter_max;
+        if (task->runs) {
+            stat.mean_jitter = std::chrono::duration<double>(task->jitter_sum) / task->runs;
+        }
+    }
+    return result;
+}
+
+void JobScheduler::timerLoop(const std::stop_token& stoken) {
+    std::unique_lock lock(m_mutex);
+
+    while (!stoken.stop_requested()) {
+        ECS_PROFILER(ZoneScoped);
+
+        std::size_t ready = 0;
+        m_wheel.advance(toTick(Clock::now()), [this, &ready](TaskPtr&& task) {
+            if (!task->cancelled) {
+                m_ready.emplace_back(std::move(task));
+                ++ready;
+            }
+        });
+
+        if (ready == 1) {
+            m_ready_cv.notify_one();
+        } else if (ready > 1) {
+            m_ready_cv.notify_all();
+        }
+
+        m_wheel_changed = false;
+        auto next       = m_wheel.nextTick();
+        if (next == TimerWheel<TaskPtr>::NEVER) {
+            m_timer_cv.wait(lock, stoken, [this] { return m_wheel_changed; });
+        } else {
+            m_timer_cv.wait_until(lock, stoken, toTime(next), [this] { return m_wheel_changed; });
+        }
+    }
+}
+
+void JobScheduler::workerLoop(const std::stop_token& stoken) {
+    std::unique_lock lock(m_mutex);
+
+    while (m_ready_cv.wait(lock, stoken, [this] { return !m_ready.empty(); })) {
+        auto task = std::move(m_ready.front());
+        m_ready.pop_front();
+
+        if (task->cancelled) {
+            continue;
+        }
+
+        ECS_PROFILER(ZoneScoped);
+
+        auto start    = Clock::now();
+        auto jitter   = std::max(start - task->deadline, Duration::zero());
+        task->running = true;
+
+        lock.unlock();
+        bool proceed = std::invoke(task->job);
+        lock.lock();
+
+        task->running = false;
+        task->runs++;
+        task->jitter_sum += jitter;
+        task->jitter_max = std::max(task->jitter_max, jitter);
+
+        if (proceed && !task->cancelled) {
+            // keep the fixed rate, but skip the missed runs
+            auto now = Clock::now();
+            do {
+                task->deadline += task->period;
+            } while (task->deadline <= now);
+
+            schedule(std::move(task));
+        } else if (!task->cancelled) {
+            std::erase(m_tasks, task);
+        }
+
+        m_done_cv.notify_all();
+    }
+}
+
+void JobScheduler::schedule(TaskPtr task) {
+    if (m_wheel.empty()) { // the wheel can be stale after a long idle
+        m_wheel.advance(toTick(Clock::now()), [](TaskPtr&&) {});
+    }
+
+    auto tick = toTick(task->deadline + RESOLUTION - Duration(1)); // round up to not run earlier
+    m_wheel.add(tick, std::move(task));
+    m_wheel_changed = true;
+    m_timer_cv.notify_one();
+}
+
+TimerWheel<JobScheduler::TaskPtr>::Tick JobScheduler::toTick(Clock::time_point time) const noexcept {
+    return static_cast<TimerWheel<TaskPtr>::Tick>(std::max(time - m_start, Duration::zero()) / RESOLUTION);
+}
+
+JobScheduler::Clock::time_point JobScheduler::toTime(TimerWheel<TaskPtr>::Tick tick) const noexcept {
+    return m_start + tick * RESOLUTION;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "simple-ecs/base_system.h"
+#include "simple-ecs/tools/timer_wheel.h"
+#include "simple-ecs/utils.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+struct JobStats {
+    SystemID                      owner = 0;
+    std::chrono::duration<double> period{};
+    std::uint64_t                 runs = 0;
+    std::chrono::duration<double> mean_jitter{}; // delay between the deadline and the real start
+    std::chrono::duration<double> max_jitter{};
+};
+
+
+// Runs periodic jobs on a few shared threads. Deadlines are kept in a hierarchical timer wheel,
+// so thousands of jobs cost one timer thread and `thread_count` workers. Threads are started by the first job.
+struct JobScheduler final : NoCopyNoMove {
+    using Clock    = std::chrono::steady_clock;
+    using Duration = Clock::duration;
+    using Job      = std::function<bool(void)>; // return false to stop the job
+
+    static inline std::size_t thread_count = std::max(2U, std::thread::hardware_concurrency() / 2);
+
+    static constexpr Duration RESOLUTION = std::chrono::microseconds(100);
+
+    JobScheduler();
+    ~JobScheduler();
+
+    void run(SystemID owner, Job&& job, Duration period);
+
+    // execute once as soon as possible
+    void post(std::function<void(void)>&& job);
+
+    // Runs the tasks on the workers and the calling thread, returns when all of them are done.
+    // Calling thread takes the tasks too, so it's safe to call from a job
+    void parallel(std::span<const std::function<void(void)>> tasks);
+
+    // stop all jobs of the owner. Waits until the running ones are finished, so don't call it from the job
+    void cancel(SystemID owner);
+    void cancelAll();
+
+    std::vector<JobStats> stats() const;
+
+private:
+    struct Task {
+        SystemID          owner;
+        Job               job;
+        Duration          period{}; // zero for the jobs posted once
+        Clock::time_point deadline;
+        bool              cancelled = false;
+        bool              running   = false;
+        std::uint64_t     runs      = 0;
+        Duration          jitter_sum{};
+        Duration          jitter_max{};
+    };
+
+    using TaskPtr = std::shared_ptr<Task>;
+
+    void start();
+    void timerLoop(const std::stop_token& stoken);
+    void workerLoop(const std::stop_token& stoken);
+    void schedule(TaskPtr task);
+
+    TimerWheel<TaskPtr>::Tick toTick(Clock::time_point time) const noexcept;
+    Clock::time_point         toTime(TimerWheel<TaskPtr>::Tick tick) const noexcept;
+
+private:
+    const Clock::time_point     m_start;
+    TimerWheel<TaskPtr>         m_wheel;
+    std::vector<TaskPtr>        m_tasks;
+    std::deque<TaskPtr>         m_ready;
+    bool                        m_wheel_changed = false;
+    std::condition_variable_any m_timer_cv;
+    std::condition_variable_any m_ready_cv;
+    std::condition_variable_any m_done_cv;
+    std::vector<std::jthread>   m_threads;
+    std::once_flag              m_started;
+
+    ECS_PROFILER(mutable TracyLockable(std::mutex, m_mutex));
+    ECS_NO_PROFILER(mutable std::mutex m_mutex);
+};
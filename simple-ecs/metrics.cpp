@@ -0,0 +1,152 @@
+#include "simple-ecs/metrics.h"
+#include "simple-ecs/tools/profiler.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+
+namespace
+{
+
+constexpr std::array QUANTILES = {std::pair{"0.5", 50.}, std::pair{"0.9", 90.}, std::pair{"0.99", 99.}};
+
+// names of functions and filters are used as label values and JSON strings
+std::string escape(std::string_view name) {
+    std::string result;
+    result.reserve(name.size());
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+void textSummary(std::string& out, std::string_view metric, std::string_view label, const Histogram& histogram) {
+    auto it = std::back_inserter(out);
+    for (const auto& [quantile, percentile] : QUANTILES) {
+        fmt::format_to(it, "{}{{{}quantile=\"{}\"}} {}\n", metric, label, quantile, histogram.percentile(percentile));
+    }
+    fmt::format_to(it, "{}{{{}quantile=\"1\"}} {}\n", metric, label, histogram.max());
+
+    // no trailing comma in the labels of the sum and the count
+    auto labels = label.empty() ? std::string{} : fmt::format("{{{}}}", label.substr(0, label.size() - 1));
+    fmt::format_to(it, "{}_sum{} {}\n", metric, labels, histogram.sum());
+    fmt::format_to(it, "{}_count{} {}\n", metric, labels, histogram.count());
+}
+
+std::string text(const Metrics& metrics) {
+    std::string out;
+    auto        it = std::back_inserter(out);
+
+    fmt::format_to(it, "# TYPE ecs_frames_total counter\necs_frames_total {}\n", metrics.frames);
+    out += "# TYPE ecs_frame_time_ns summary\n";
+    textSummary(out, "ecs_frame_time_ns", {}, metrics.frame_time);
+
+    out += "# TYPE ecs_function_time_ns summary\n";
+    for (const auto& function : metrics.functions) {
+        auto label = fmt::format("function=\"{}\",", escape(function.name));
+        textSummary(out, "ecs_function_time_ns", label, function.time);
+    }
+    out += "# TYPE ecs_function_entities_total counter\n";
+    for (const auto& function : metrics.functions) {
+        fmt::format_to(
+          it, "ecs_function_entities_total{{function=\"{}\"}} {}\n", escape(function.name), function.entities);
+    }
+
+    out += "# TYPE ecs_observer_refresh_ns summary\n";
+    for (const auto& observer : metrics.observers) {
+        auto label = fmt::format("observer=\"{}\",", escape(observer.name));
+        textSummary(out, "ecs_observer_refresh_ns", label, observer.refresh);
+    }
+    out += "# TYPE ecs_observer_entities gauge\n";
+    for (const auto& observer : metrics.observers) {
+        fmt::format_to(it, "ecs_observer_entities{{observer=\"{}\"}} {}\n", escape(observer.name), observer.entities);
+    }
+
+    return out;
+}
+
+void jsonHistogram(std::string& out, const Histogram& histogram) {
+    fmt::format_to(std::back_inserter(out),
+                   R"({{"count":{},"min":{},"mean":{:.1f},"p50":{},"p90":{},"p99":{},"max":{}}})",
+                   histogram.count(),
+                   histogram.min(),
+                   histogram.mean(),
+                   histogram.percentile(50.),
+                   histogram.percentile(90.),
+                   histogram.percentile(99.),
+                   histogram.max());
+}
+
+std::string json(const Metrics& metrics) {
+    std::string out;
+    auto        it = std::back_inserter(out);
+
+    fmt::format_to(it, R"({{"frames":{},"frame_time_ns":)", metrics.frames);
+    jsonHistogram(out, metrics.frame_time);
+
+    out += R"(,"functions":[)";
+    for (const auto& function : metrics.functions) {
+        fmt::format_to(it,
+                       R"({}{{"name":"{}","entities":{},"time_ns":)",
+                       &function == &metrics.functions.front() ? "" : ",",
+                       escape(function.name),
+                       function.entities);
+        jsonHistogram(out, function.time);
+        out += '}';
+    }
+
+    out += R"(],"observers":[)";
+    for (const auto& observer : metrics.observers) {
+        fmt::format_to(it,
+                       R"({}{{"name":"{}","entities":{},"refresh_ns":)",
+                       &observer == &metrics.observers.front() ? "" : ",",
+                       escape(observer.name),
+                       observer.entities);
+        jsonHistogram(out, observer.refresh);
+        out += '}';
+    }
+    out += "]}\n";
+
+    return out;
+}
+
+} // namespace
+
+
+std::string dumpMetrics(const Metrics& metrics, MetricsFormat format) {
+    ECS_PROFILER(ZoneScoped);
+
+    return format == MetricsFormat::Json ? json(metrics) : text(metrics);
+}
+
+bool dumpMetrics(const Metrics& metrics, const std::filesystem::path& path, MetricsFormat format) {
+    ECS_PROFILER(ZoneScoped);
+
+    auto tmp = path;
+    tmp += ".tmp";
+
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        auto          dump = dumpMetrics(metrics, format);
+        if (!file.write(dump.data(), static_cast<std::streamsize>(dump.size()))) {
+            spdlog::error("Cannot write metrics to {}", tmp.string());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmp, path, error);
+    if (error) {
+        spdlog::error("Cannot replace {}: {}", path.string(), error.message());
+        return false;
+    }
+    return true;
+}
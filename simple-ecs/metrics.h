@@ -0,0 +1,39 @@
+#pragma once
+
+#include "simple-ecs/tools/histogram.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+// Latencies are in nanoseconds
+struct FunctionMetrics {
+    std::string   name;
+    Histogram     time;
+    std::uint64_t entities = 0; // entities in the observers of the function summed over all calls
+};
+
+struct ObserverMetrics {
+    std::string   name;
+    Histogram     refresh;
+    std::uint64_t entities = 0; // entities after the last refresh
+};
+
+struct Metrics {
+    std::uint64_t                frames = 0;
+    Histogram                    frame_time;
+    std::vector<FunctionMetrics> functions;
+    std::vector<ObserverMetrics> observers;
+};
+
+enum class MetricsFormat : std::uint8_t {
+    Text, // Prometheus text exposition format
+    Json,
+};
+
+std::string dumpMetrics(const Metrics& metrics, MetricsFormat format);
+
+// The file is replaced at once, so a reader never sees a half written dump. Use a path in /dev/shm to keep it in memory
+bool dumpMetrics(const Metrics& metrics, const std::filesystem::path& path, MetricsFormat format);
@@ -4,6 +4,8 @@
 #include "simple-ecs/filter.h"
 #include "simple-ecs/world.h"
 
+#include <limits>
+#include <ranges>
 
 #define OBSERVER(Filter) const Observer<Filter>&
 #define OBSERVER_EMPTY const Observer<>&
@@ -14,6 +16,26 @@ struct Observer;
 namespace detail::observer
 {
 
+inline constexpr std::uint64_t NO_RUN = std::numeric_limits<std::uint64_t>::max();
+
+// run of the function executed on this thread, set by the registry for the time of each call. `Observer::slice` takes
+// its part from it, so each function slices the shared observers by its own runs
+inline thread_local std::uint64_t current_run = NO_RUN;
+
+struct RunScope final : NoCopyNoMove {
+    explicit RunScope(std::uint64_t run) noexcept : m_previous(current_run) { current_run = run; }
+    ~RunScope() noexcept { current_run = m_previous; }
+
+private:
+    std::uint64_t m_previous;
+};
+
+// part of the entity in `Observer::slice`. Fibonacci hashing spreads IDs created in a pattern over all parts
+inline std::size_t slice(Entity e, std::size_t parts) noexcept {
+    constexpr std::uint64_t GOLDEN = 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(e) * GOLDEN) >> 32U) % parts;
+}
+
 template<typename...>
 struct ArchetypeConstructor;
 
@@ -52,6 +74,9 @@ struct Observer final : NoCopyNoMove {
 
     using Require = typename Filter::Require::Type;
     using Exclude = typename Filter::Exclude::Type;
+    using Changes = OnlyChanged_t<Require>; // Changed<Component> in the Require list
+
+    static_assert(std::is_same_v<OnlyChanged_t<Exclude>, Components<>>, "Changed can be used only in the Require list");
 
     Observer(World& world) : m_world(world) { refresh(); }
     ~Observer() noexcept = default;
@@ -74,6 +99,10 @@ struct Observer final : NoCopyNoMove {
         std::lock_guard _(m_mutex);
         return m_entities.empty();
     }
+    MemoryBlock memory() const noexcept {
+        std::lock_guard _(m_mutex);
+        return {m_entities.size() * sizeof(Entity), m_entities.capacity() * sizeof(Entity)};
+    }
 
     std::span<const Entity> entities() const noexcept { return *this; }
     operator std::span<const Entity>() const noexcept {
@@ -81,9 +110,32 @@ struct Observer final : NoCopyNoMove {
         return {m_entities.cbegin(), m_entities.cend()};
     }
 
+    // Returns part `run % parts` of entities, where `run` counts the runs of the calling function. Entities are split
+    // by a hash of ID, so every entity is visited once per `parts` runs, even if the set of entities is changing.
+    // Calls in the same run return the same part. The hash keeps the parts balanced when IDs of an archetype follow
+    // a pattern, e.g. all even. The run is known only inside the function, jobs and other threads pass their own.
+    // The slice is a view of the entity list like `begin`/`end`: it is valid until the observer is refreshed, so don't
+    // keep it after the run
+    decltype(auto) slice(std::size_t parts) const {
+        assert(detail::observer::current_run != detail::observer::NO_RUN &&
+               "Slice is taken outside of a function, pass the run");
+        return slice(parts, detail::observer::current_run);
+    }
+
+    decltype(auto) slice(std::size_t parts, std::uint64_t run) const {
+        assert(parts && "Cannot split entities into 0 parts");
+
+        std::lock_guard _(m_mutex);
+        auto            part = static_cast<std::size_t>(run % parts);
+
+        return std::span<const Entity>{m_entities.cbegin(), m_entities.cend()}
+             | std::views::filter([parts, part](Entity e) { return detail::observer::slice(e, parts) == part; })
+             | std::views::transform([this](Entity e) { return EntityWrapper(e, *this); });
+    }
+
     ECS_FORCEINLINE decltype(auto) operator[](std::size_t index) const {
         std::lock_guard _(m_mutex);
-        assert(index >= 0 && index < m_entities.size() && "Out of bound");
+        assert(index < m_entities.size() && "Out of bound");
         return EntityWrapper(m_entities[index], *this);
     }
 
@@ -169,6 +221,23 @@ struct Observer final : NoCopyNoMove {
         (m_world.markUpdated<Component>(entities()), ...);
     }
 
+    template<typename... Component, EcsTarget Target>
+    ECS_FORCEINLINE void markChanged(Target target) const {
+        ECS_PROFILER(ZoneScoped);
+
+        static_assert(ANY_OF<Components<Component...>, Exclude>, "Component is in the Exclude list");
+        (m_world.markChanged<Component>(target), ...);
+    }
+
+    template<typename... Component>
+    ECS_FORCEINLINE void markChanged() const {
+        ECS_PROFILER(ZoneScoped);
+
+        static_assert(ALL_OF<Components<Component...>, Require>, "Component is not in the Require list");
+        static_assert(ANY_OF<Components<Component...>, Exclude>, "Component is in the Exclude list");
+        (m_world.markChanged<Component>(entities()), ...);
+    }
+
     template<typename... Component, EcsTarget Target>
     ECS_FORCEINLINE void clearUpdateTag(Target target) const {
         ECS_PROFILER(ZoneScoped);
@@ -202,22 +271,33 @@ struct Observer final : NoCopyNoMove {
         (m_world.erase<Component>(entities()), ...);
     }
 
-    template<typename Component>
+    // `get<T>` counts as a change of T, read with `get<const T>`
+    template<typename Component, typename Type = std::remove_const_t<Component>>
     requires(!std::is_empty_v<Component>)
     [[nodiscard]] ECS_FORCEINLINE decltype(auto) get(Entity e) const noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        static_assert(ALL_OF<Components<Component>, Require>, "Component is not in the Require list");
-        static_assert(ANY_OF<Components<Component>, Exclude>, "Component is in the Exclude list");
+        static_assert(ALL_OF<Components<Type>, Require>, "Component is not in the Require list");
+        static_assert(ANY_OF<Components<Type>, Exclude>, "Component is in the Exclude list");
         return m_world.get<Component>(e);
     }
 
     template<typename Component>
     requires(!std::is_empty_v<Component>)
-    [[nodiscard]] ECS_FORCEINLINE decltype(auto) tryGet(Entity e) const noexcept {
+    [[nodiscard]] ECS_FORCEINLINE decltype(auto) getChanged(Entity e) const noexcept {
         ECS_PROFILER(ZoneScoped);
 
+        static_assert(ALL_OF<Components<Component>, Require>, "Component is not in the Require list");
         static_assert(ANY_OF<Components<Component>, Exclude>, "Component is in the Exclude list");
+        return m_world.getChanged<Component>(e);
+    }
+
+    template<typename Component, typename Type = std::remove_const_t<Component>>
+    requires(!std::is_empty_v<Component>)
+    [[nodiscard]] ECS_FORCEINLINE decltype(auto) tryGet(Entity e) const noexcept {
+        ECS_PROFILER(ZoneScoped);
+
+        static_assert(ANY_OF<Components<Type>, Exclude>, "Component is in the Exclude list");
         return m_world.tryGet<Component>(e);
     }
 
@@ -227,10 +307,17 @@ private:
 
         m_world.notify(m_entities);
 
-        auto filtered = FilteredEntities<AND<Require>>::ents(m_world);
+        auto filtered = FilteredEntities<AND<RemoveChanged_t<Require>>>::ents(m_world);
         auto excluded = FilteredEntities<OR<Exclude>>::ents(m_world);
         auto result   = std::move(filtered) - std::move(excluded);
 
+        // observers can be refreshed twice in a tick, the second refresh has to see the same changes
+        if (auto tick = m_world.tick(); tick != m_refresh_tick) {
+            m_changed_since = m_refresh_tick;
+            m_refresh_tick  = tick;
+        }
+        ChangedEntities<Changes>::keep(m_world, *result, m_changed_since);
+
         std::lock_guard _(m_mutex);
         m_entities.swap(*result);
     }
@@ -238,6 +325,8 @@ private:
 private:
     World&              m_world;
     std::vector<Entity> m_entities;
+    Tick                m_refresh_tick  = 0;
+    Tick                m_changed_since = 0; // changes at this tick or later pass Changed<Component>
 
     ECS_PROFILER(mutable TracyLockable(std::mutex, m_mutex));
     ECS_NO_PROFILER(mutable std::mutex m_mutex);
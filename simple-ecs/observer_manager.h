@@ -1,7 +1,11 @@
 #pragma once
 
+#include "simple-ecs/metrics.h"
 #include "simple-ecs/observer.h"
 #include "simple-ecs/utils.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <shared_mutex>
 
 
@@ -9,8 +13,8 @@ namespace detail::observer
 {
 
 inline IDType nextID() {
-    static IDType id = 0;
-    return id++;
+    static std::atomic<IDType> id = 0;
+    return id.fetch_add(1, std::memory_order_relaxed);
 }
 
 template<typename T>
@@ -27,14 +31,25 @@ struct ObserverManager : NoCopyNoMove {
 
     static inline size_t thread_count = std::thread::hardware_concurrency();
 
+    // every world has its own observers, ids are shared to index them. Observer is created on the first use
     template<typename Filter>
-    ECS_FORCEINLINE static Observer<Filter>& observers(World& world) {
-        static Observer<Filter> observer{world};
-        return observer;
-    };
+    ECS_FORCEINLINE Observer<Filter>& observers() {
+        auto observer_id = detail::observer::sequenceID<Filter>();
+        assert(observer_id < m_observers.size() && "Observer is not registered");
+
+        auto& observer = m_observers[observer_id];
+        if (!observer) {
+            observer = std::make_shared<Observer<Filter>>(m_world);
+        }
+        return *static_cast<Observer<Filter>*>(observer.get());
+    }
 
 public:
     ~ObserverManager() noexcept {
+        if (m_threads.empty()) {
+            return;
+        }
+
         for (auto& thread : m_threads) {
             thread.request_stop();
         }
@@ -52,15 +67,34 @@ public:
         }
     }
 
+    // wakes the filter threads, they are started by the first call. Worlds calculated only by `Registry::step`
+    // refresh their observers inline and never start them
     ECS_FORCEINLINE void triger() {
         ECS_PROFILER(ZoneScoped);
 
+        if (m_threads.empty()) [[unlikely]] {
+            start();
+        }
+
         m_current_function.store(0, std::memory_order_relaxed);
         m_finished_function.store(0, std::memory_order_relaxed);
         m_sync.store(!m_sync.load(std::memory_order_acquire), std::memory_order_release);
         m_sync.notify_all();
     }
 
+    // refreshes the due observers on the calling thread, `sync` returns right away after it
+    void refresh() {
+        ECS_PROFILER(ZoneScoped);
+
+        std::shared_lock _(m_mutex);
+        for (size_t i = 0; i < m_functions.size(); ++i) {
+            if (m_observers_due[i]) {
+                std::invoke(m_functions[i]);
+            }
+        }
+        m_finished_function.store(static_cast<std::uint16_t>(m_functions.size()), std::memory_order_relaxed);
+    }
+
     template<typename Filter>
     void registerObserver(std::uint32_t fname) {
         std::unique_lock _(m_mutex);
@@ -69,15 +103,44 @@ public:
 
         m_funcs_to_observers[fname].emplace_back(observer_id);
         m_observers_in_use[observer_id]++;
+        TrackUpdates<typename Filter::Require::Type>::create(m_world);
+        TrackUpdates<typename Filter::Exclude::Type>::create(m_world);
+
+        // ids of observers used only by other worlds stay empty
+        if (m_observers.size() <= observer_id) {
+            m_observers.resize(observer_id + 1);
+            m_functions.resize(observer_id + 1, [] {});
+            m_memory.resize(observer_id + 1, [] { return MemoryBlock{}; });
+            ECS_NOT_FINAL_ONLY(m_metrics.resize(observer_id + 1));
+        }
 
+        m_memory[observer_id] = [this, observer_id] {
+            const auto* observer = static_cast<const Observer<Filter>*>(m_observers[observer_id].get());
+            return observer ? observer->memory() : MemoryBlock{};
+        };
 
-        auto function = [](World& world) { observers<Filter>(world).refresh(); };
-        if (m_functions.size() == observer_id) {
-            m_functions.emplace_back(std::move(function));
-        }
-        if (m_observers_in_use[observer_id]) {
-            m_functions[observer_id] = std::move(function);
-        }
+#ifdef ECS_FINAL
+        m_functions[observer_id] = [this] {
+            ECS_TRACE(ct::NAME<Filter>);
+            observers<Filter>().refresh();
+        };
+#else
+        m_metrics[observer_id].name = ct::NAME<Filter>;
+        m_functions[observer_id]    = [this, observer_id] {
+            using namespace std::chrono;
+            ECS_TRACE(ct::NAME<Filter>);
+
+            auto  start    = steady_clock::now();
+            auto& observer = observers<Filter>();
+            observer.refresh();
+
+            auto  time    = duration_cast<nanoseconds>(steady_clock::now() - start);
+            auto& metrics = m_metrics[observer_id];
+            metrics.refresh.record(static_cast<std::uint64_t>(time.count()));
+            metrics.entities = observer.size();
+        };
+#endif
+        m_observers_due.resize(m_functions.size(), true);
     };
 
     void unregisterObserver(std::uint32_t fname) {
@@ -87,22 +150,65 @@ public:
             assert(m_observers_in_use[observer_id]);
             --m_observers_in_use[observer_id];
             if (!m_observers_in_use[observer_id]) {
-                m_functions[observer_id] = [](World&) {};
+                m_functions[observer_id] = [] {};
             }
         }
     };
 
+    // refresh time of the registered observers. Don't call it while observers are refreshed
+    void metrics([[maybe_unused]] std::vector<ObserverMetrics>& result) const {
+        ECS_NOT_FINAL_ONLY(std::ranges::copy_if(
+          m_metrics, std::back_inserter(result), [](const auto& metrics) { return !metrics.name.empty(); }));
+    }
+
+    // cached entities of all observers
+    MemoryBlock memory() const {
+        std::shared_lock _(m_mutex);
+
+        MemoryBlock result;
+        for (const auto& memory : m_memory) {
+            result += memory();
+        }
+        return result;
+    }
+
+    void resetMetrics() {
+        ECS_NOT_FINAL_ONLY(for (auto& metrics : m_metrics) { metrics.refresh.reset(); })
+    }
+
+    // observers are refreshed only when at least one of their functions is due
+    void resetDue() {
+        std::unique_lock _(m_mutex);
+        std::ranges::fill(m_observers_due, false);
+    }
+
+    void markDue(std::uint32_t fname) {
+        std::unique_lock _(m_mutex);
+
+        if (auto it = m_funcs_to_observers.find(fname); it != m_funcs_to_observers.end()) {
+            for (auto observer_id : it->second) {
+                m_observers_due[observer_id] = true;
+            }
+        }
+    }
+
 
 private:
-    ObserverManager(World& world) : m_sync(false) {
+    ObserverManager(World& world) : m_world(world), m_sync(false) {}
+
+    void start() {
         m_threads.reserve(thread_count);
 
         for (size_t i = 0; i < thread_count; ++i) {
-            auto& thread = m_threads.emplace_back([this, &world](const std::stop_token& stoken) {
+            auto& thread = m_threads.emplace_back([this](const std::stop_token& stoken) {
                 ECS_PROFILER(tracy::SetThreadName("ECS Filter Thread"));
 
+                // the value seen by the last wake up. Threads are started by the first triger before it flips
+                // `m_sync`, so the first wake up can't be missed
+                bool phase = false;
                 while (true) {
-                    m_sync.wait(m_sync.load(std::memory_order_relaxed), std::memory_order_acquire);
+                    m_sync.wait(phase, std::memory_order_acquire);
+                    phase = m_sync.load(std::memory_order_acquire);
                     std::shared_lock _(m_mutex);
 
                     if (stoken.stop_requested()) {
@@ -114,7 +220,9 @@ private:
                     for (auto i = m_current_function.fetch_add(1, std::memory_order_relaxed); //
                          static_cast<size_t>(i) < m_functions.size();
                          i = m_current_function.fetch_add(1, std::memory_order_relaxed)) {
-                        std::invoke(m_functions[i], world);
+                        if (m_observers_due[i]) {
+                            std::invoke(m_functions[i]);
+                        }
                         m_finished_function.fetch_add(1, std::memory_order_relaxed);
                     }
                 }
@@ -128,14 +236,19 @@ private:
     };
 
 private:
+    World&                                          m_world;
     std::vector<std::jthread>                       m_threads;
     std::unordered_map<size_t, std::vector<size_t>> m_funcs_to_observers;
     std::unordered_map<size_t, size_t>              m_observers_in_use;
-    std::vector<std::function<void(World&)>>        m_functions;
+    std::vector<std::shared_ptr<void>>              m_observers; // Observer<Filter> by `sequenceID<Filter>`
+    std::vector<std::function<void(void)>>          m_functions;
+    std::vector<std::function<MemoryBlock(void)>>   m_memory;
+    std::vector<std::uint8_t>                       m_observers_due;
+    ECS_NOT_FINAL_ONLY(std::vector<ObserverMetrics> m_metrics); // by observer id
     std::atomic_uint16_t                            m_current_function;
     std::atomic_uint16_t                            m_finished_function;
     std::atomic_bool                                m_sync;
 
-    ECS_PROFILER(TracySharedLockable(std::shared_mutex, m_mutex));
-    ECS_NO_PROFILER(std::shared_mutex m_mutex);
+    ECS_PROFILER(mutable TracySharedLockable(std::shared_mutex, m_mutex));
+    ECS_NO_PROFILER(mutable std::shared_mutex m_mutex);
 };
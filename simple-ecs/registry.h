@@ -1,8 +1,11 @@
 #pragma once
 
 #include "simple-ecs/base_system.h"
+#include "simple-ecs/job_scheduler.h"
 #include "simple-ecs/observer_manager.h"
+#include "simple-ecs/schedule.h"
 #include "simple-ecs/serializer.h"
+#include "simple-ecs/task.h"
 #include "simple-ecs/utils.h"
 #include "simple-ecs/world.h"
 
@@ -11,8 +14,11 @@
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <mutex>
 #include <queue>
 #include <ranges>
+#include <span>
+#include <stop_token>
 #include <thread>
 #include <utility>
 
@@ -28,6 +34,11 @@
 #define ECS_REG_FUNC_SYS(REGISTRY, FUNC, SYSTEM) REGISTRY.registerFunction(ECS_FUNCTION_ID(FUNC), &FUNC, SYSTEM)
 #define ECS_REG_EXTERN_FUNC(REGISTRY, FUNC) REGISTRY.registerFunction(ECS_FUNCTION_ID(FUNC), &FUNC)
 #define ECS_UNREG_FUNC(REGISTRY, FUNC) REGISTRY.unregisterFunction(ECS_FUNCTION_ID(FUNC))
+
+// variadic to allow designated initializers: Schedule{.phase = Phase::Render, .every = 2}
+#define ECS_REG_FUNC_SCHEDULED(REGISTRY, FUNC, ...) REGISTRY.registerFunction(ECS_FUNCTION_ID(FUNC), &FUNC, this, __VA_ARGS__)
+#define ECS_REG_FUNC_SYS_SCHEDULED(REGISTRY, FUNC, SYSTEM, ...) REGISTRY.registerFunction(ECS_FUNCTION_ID(FUNC), &FUNC, SYSTEM, __VA_ARGS__)
+#define ECS_REG_EXTERN_FUNC_SCHEDULED(REGISTRY, FUNC, ...) REGISTRY.registerFunction(ECS_FUNCTION_ID(FUNC), &FUNC, __VA_ARGS__)
 // clang-format on
 
 #define ECS_JOB_RUN(REGISTRY, FUNC, cycle) \
@@ -38,32 +49,40 @@
 
 
 struct Registry final : NoCopyNoMove {
-    Registry(World& world) : m_world(world), m_frame_ready(false), m_serializer(m_world), m_observer_manager(world) {}
+    Registry(World& world)
+      : m_world(world)
+      , m_frame_ready(false)
+      , m_serializer(m_world, m_jobs)
+      , m_observer_manager(world) {}
     ~Registry() {
         ECS_PROFILER(ZoneScoped);
 
         for (const auto& system : std::views::values(m_systems)) {
             system->stop(*this);
         }
-        m_parallel_jobs.clear();
+        m_serializer.finishAsync(); // the posted saves would be cancelled with the jobs
+        m_jobs.cancelAll();
         cleanup();
     }
 
     Serializer& serializer() noexcept { return m_serializer; }
 
 #ifdef ECS_FINAL
-    template<typename System, typename... Filters>
+    template<typename System, EcsFunctionResult Result, typename... Filters>
     requires(sizeof...(Filters) > 0 && std::derived_from<System, BaseSystem>)
-    void registerFunction(std::uint32_t id, void (System::*f)(OBSERVER(Filters)...), System* obj) {
+    void registerFunction(std::uint32_t id,
+                          Result (System::*f)(OBSERVER(Filters)...),
+                          System*         obj,
+                          const Schedule& schedule = {}) {
         (m_observer_manager.registerObserver<Filters>(id), ...);
-        m_functions.emplace_back(id, f, obj, m_world);
+        addFunction({id, f, obj, m_observer_manager, schedule});
     }
 
-    template<typename... Filters>
+    template<EcsFunctionResult Result, typename... Filters>
     requires(sizeof...(Filters) > 0)
-    void registerFunction(std::uint32_t id, void (*f)(OBSERVER(Filters)...)) {
+    void registerFunction(std::uint32_t id, Result (*f)(OBSERVER(Filters)...), const Schedule& schedule = {}) {
         (m_observer_manager.registerObserver<Filters>(id), ...);
-        m_functions.emplace_back(id, f, m_world);
+        addFunction({id, f, m_observer_manager, schedule});
     }
 
     void unregisterFunction(std::uint32_t id) {
@@ -71,9 +90,12 @@ struct Registry final : NoCopyNoMove {
         m_cleanup_callbacks.emplace([this, id] { std::erase(m_functions, id); });
     }
 #else
-    template<typename System, typename... Filters>
+    template<typename System, EcsFunctionResult Result, typename... Filters>
     requires(sizeof...(Filters) > 0 && std::derived_from<System, BaseSystem>)
-    void registerFunction(std::string_view fname, void (System::*f)(OBSERVER(Filters)...), System* obj) {
+    void registerFunction(std::string_view fname,
+                          Result (System::*f)(OBSERVER(Filters)...),
+                          System*         obj,
+                          const Schedule& schedule = {}) {
         ECS_PROFILER(ZoneScoped);
 
         bool exists = std::ranges::find(m_functions, fname) != m_functions.end();
@@ -85,12 +107,12 @@ struct Registry final : NoCopyNoMove {
         }
 
         (m_observer_manager.registerObserver<Filters>(crc32::compute(fname)), ...);
-        m_functions.emplace_back(fname, f, obj, m_world);
+        addFunction({fname, f, obj, m_observer_manager, schedule});
     }
 
-    template<typename... Filters>
+    template<EcsFunctionResult Result, typename... Filters>
     requires(sizeof...(Filters) > 0)
-    void registerFunction(std::string_view fname, void (*f)(OBSERVER(Filters)...)) {
+    void registerFunction(std::string_view fname, Result (*f)(OBSERVER(Filters)...), const Schedule& schedule = {}) {
         ECS_PROFILER(ZoneScoped);
 
         bool exists = std::ranges::find(m_functions, fname) != m_functions.end();
@@ -102,7 +124,7 @@ struct Registry final : NoCopyNoMove {
         }
 
         (m_observer_manager.registerObserver<Filters>(crc32::compute(fname)), ...);
-        m_functions.emplace_back(fname, f, m_world);
+        addFunction({fname, f, m_observer_manager, schedule});
     }
 
     void unregisterFunction(std::string_view fname) {
@@ -120,37 +142,42 @@ struct Registry final : NoCopyNoMove {
     }
 #endif
 
+    // execute job every `every` on the shared job threads until it returns ECS_JOB_STOP or the system is removed
     template<typename System, typename Time>
     requires std::derived_from<System, BaseSystem>
     void runParallelJob(ECS_JOB (System::*func)(), System* obj, Time every) {
         ECS_PROFILER(ZoneScoped);
 
-        using namespace std::literals;
+        m_jobs.run(
+          ct::ID<System>,
+          [func, obj] { return std::invoke(func, obj); },
+          std::chrono::duration_cast<JobScheduler::Duration>(every));
 
-        assert(every >= 100ms && "Doesn't support time less than 100ms");
-        m_parallel_jobs[ct::ID<Component>].emplace_back(
-          [](const std::stop_token& stoken, ECS_JOB (System::*function)(), System* obj, Time time) {
-              ECS_PROFILER(ZoneScoped);
+        spdlog::debug("Job for {} was started", ct::NAME<System>);
+    }
 
-              spdlog::stopwatch sw;
+    std::vector<JobStats> getJobsInfo() const { return m_jobs.stats(); }
 
-              while (!stoken.stop_requested()) {
-                  ECS_PROFILER(ZoneScoped);
+    // awaitables for Task coroutines
+    auto nextFrame() noexcept { return detail::task::Awaiter{m_waiting, detail::task::Wait::Frame}; }
 
-                  if (sw.elapsed() > time) {
-                      sw.reset();
-                      if (std::invoke(function, obj) == ECS_JOB_STOP) {
-                          return;
-                      }
-                  }
-                  std::this_thread::sleep_for(time - sw.elapsed());
-              }
-          },
-          func,
-          obj,
-          every);
+    template<typename Rep, typename Period>
+    auto after(std::chrono::duration<Rep, Period> time) noexcept {
+        auto wake_at = std::chrono::steady_clock::now() + std::chrono::ceil<std::chrono::steady_clock::duration>(time);
+        return detail::task::Awaiter{m_waiting, detail::task::Wait::Time, wake_at};
+    }
 
-        spdlog::debug("Job for {} was started", ct::NAME<System>);
+    // execute job on the job threads and resume the coroutine in the first frame after it is finished
+    template<typename Callable>
+    requires std::is_invocable_v<Callable>
+    auto async(Callable&& job) {
+        return detail::task::JobAwaiter<std::decay_t<Callable>>{m_waiting, m_jobs, std::forward<Callable>(job)};
+    }
+
+    // thread safe way to modify the World from jobs. Commands are applied at the end of the frame
+    void defer(std::function<void(World&)> command) {
+        std::lock_guard _(m_deferred_mutex);
+        m_deferred_commands.emplace_back(std::move(command));
     }
 
     template<typename System, typename... Args>
@@ -185,7 +212,7 @@ struct Registry final : NoCopyNoMove {
         m_cleanup_callbacks.emplace([system = std::move(system), this] {
             spdlog::debug("remove: {}", ct::NAME<System>);
             system->second.get()->stop(*this);
-            m_parallel_jobs.erase(ct::ID<System>);
+            m_jobs.cancel(ct::ID<System>);
             m_systems.erase(system);
         });
     }
@@ -230,37 +257,155 @@ struct Registry final : NoCopyNoMove {
         while (!m_frame_ready.load(std::memory_order_relaxed)) {}
     }
 
-    void prepare() noexcept { m_observer_manager.triger(); }
+    void prepare() noexcept { prepare(elapsed()); }
+
+    // `dt` is the simulated time since the previous frame, e.g. the fixed tick of a server
+    void prepare(Schedule::Duration dt) noexcept {
+        ECS_PROFILER(ZoneScoped);
+        ECS_TRACE("Registry::prepare");
+
+        schedule(dt);
+        m_observer_manager.triger();
+    }
+
+    std::uint64_t frame() const noexcept { return m_frame; }
+
+    // Deferrable functions are postponed when the estimated frame time exceeds the budget. The estimation includes
+    // the measured cost of the critical functions due later in the frame. Zero to disable.
+    // Function cannot be deferred more than `max_deferred_frames` frames in a row.
+    void setFrameBudget(Schedule::Duration budget, std::uint32_t max_deferred_frames = 10) noexcept {
+        m_frame_budget        = budget;
+        m_max_deferred_frames = max_deferred_frames;
+    }
+
+    const FrameStats& frameStats() const noexcept { return m_frame_stats; }
 
     void exec() noexcept {
+        calculate();
+        m_frame_ready.store(true, std::memory_order_relaxed);
+    }
+
+    // Headless server loop, calculates frames until `stop` is requested or `config.frames` are done. Frames start
+    // every `config.tick`, the loop sleeps between them and spins the last `config.spin` to start on time.
+    // Late frames are caught up back to back, up to `max_catch_up` ticks, the older ones are dropped
+    void run(const RunConfig& config, std::stop_token stop = {}) {
         ECS_PROFILER(ZoneScoped);
 
-        assert(m_init_callbacks.empty() && "all systems must be initialized");
+        using Clock = std::chrono::steady_clock;
 
-        m_observer_manager.sync();
-        for (const auto& function : m_functions) {
-            function();
-        }
+        const auto tick = std::chrono::duration_cast<Clock::duration>(config.tick);
+        const auto spin = std::chrono::duration_cast<Clock::duration>(config.spin);
 
-        cleanup();
-        m_world.flush(); // destroy all removed entities at the end of the frame
+        RunStats stats;
+        auto     next = Clock::now();
+        publish(stats);
+
+        while (!stop.stop_requested() && (!config.frames || stats.frames < config.frames)) {
+            const auto start = Clock::now();
 
-        { // optimize one storage
-            static uint16_t storage_id = 0;
-            static uint8_t  frame      = 0;
+            initNewSystems();
+            if (tick > Clock::duration::zero()) {
+                m_last_prepare = start;
+                prepare(config.tick);
+            } else {
+                prepare();
+            }
+            calculate(); // nobody waits for `m_frame_ready` of a headless loop
+
+            const auto end = Clock::now();
+            stats.frames++;
+            stats.busy += end - start;
+
+            if (tick <= Clock::duration::zero()) {
+                publish(stats);
+                continue;
+            }
 
-            ++frame;
-            frame &= 60; // run every 60 frames
+            if (end - start > tick) {
+                stats.overruns++;
+                stats.max_overrun = std::max<Schedule::Duration>(stats.max_overrun, end - start - tick);
+            }
 
-            if (!frame) {
-                m_world.optimize(storage_id);
-                storage_id = storage_id % static_cast<uint16_t>(m_world.totalComponents());
+            next += tick;
+            if (const auto behind = (end - next) / tick; behind > config.max_catch_up) {
+                const auto dropped = static_cast<std::uint64_t>(behind) - config.max_catch_up;
+                stats.dropped += dropped;
+                next += tick * dropped;
             }
+
+            waitUntil(next, spin);
+            stats.idle += Clock::now() - end;
+            publish(stats);
         }
+    }
 
-        m_frame_ready.store(true, std::memory_order_relaxed);
+    // copy of the stats published after every frame of `run`, safe to call from another thread during the run
+    RunStats runStats() const {
+        std::lock_guard _(m_run_stats_mutex);
+        return m_run_stats;
     }
 
+    // Calculates one frame of every world and returns when all worlds are done. The worlds share one scheduler:
+    // each frame is a task on the job threads of the first world and the calling thread takes the tasks too, so the
+    // thread count doesn't grow with the worlds. Periodic jobs of the first world wait for free workers meanwhile.
+    // Jobs started by a frame, e.g. `runParallelJob` or parallel saves, run on the scheduler of its own world.
+    // Observers are refreshed inline by the frame, so the worlds don't wake their own filter threads.
+    // Captures of the async saves and the storage maintenance are done on the calling thread after all frames
+    static void step(std::span<World* const> worlds) {
+        ECS_PROFILER(ZoneScoped);
+
+        if (worlds.empty()) {
+            return;
+        }
+
+        std::vector<std::function<void(void)>> tasks;
+        tasks.reserve(worlds.size());
+        for (auto* world : worlds) {
+            tasks.emplace_back([reg = world->getRegistry()] {
+                reg->initNewSystems();
+                reg->schedule(reg->elapsed());
+                reg->m_observer_manager.refresh();
+                reg->runFunctions();
+            });
+        }
+
+        worlds.front()->getRegistry()->m_jobs.parallel(tasks);
+        for (auto* world : worlds) {
+            world->getRegistry()->maintain();
+        }
+    }
+
+    // Latency histograms of the frames, functions and observers since the start or `resetMetrics`.
+    // Call it between frames. Metrics are compiled out in the final build
+    Metrics metrics() const {
+        ECS_PROFILER(ZoneScoped);
+
+        Metrics metrics;
+#ifndef ECS_FINAL
+        metrics.frames     = m_frame;
+        metrics.frame_time = m_frame_time;
+        metrics.functions.reserve(m_functions.size());
+        for (const auto& function : m_functions) {
+            metrics.functions.emplace_back(function.metrics());
+        }
+        m_observer_manager.metrics(metrics.observers);
+#endif
+        return metrics;
+    }
+
+    void resetMetrics() {
+#ifndef ECS_FINAL
+        m_frame_time.reset();
+        for (const auto& function : m_functions) {
+            function.metrics().time.reset();
+            function.metrics().entities = 0;
+        }
+        m_observer_manager.resetMetrics();
+#endif
+    }
+
+    MemoryBlock observersMemory() const { return m_observer_manager.memory(); }
+
     // save including filtering time
     std::vector<std::pair<double, std::string_view>> getRegisteredFunctionsInfo() {
 #ifdef ECS_FINAL
@@ -284,26 +429,60 @@ private:
         Function& operator=(Function&& other) noexcept = default;
         ~Function() noexcept                           = default;
 
-        template<typename System, typename... Filters>
+        template<typename System, typename Result, typename... Filters>
         Function(ECS_FINAL_SWITCH(std::uint32_t, std::string_view) id, //
-                 void (System::*f)(OBSERVER(Filters)...),
-                 System* obj,
-                 World&  world)
-          : m_function([f, obj, &world] { std::invoke(f, obj, ObserverManager::observers<Filters>(world)...); })
-          , m_id(id){};
-
-        template<typename... Filters>
+                 Result (System::*f)(OBSERVER(Filters)...),
+                 System*          obj,
+                 ObserverManager& observers,
+                 const Schedule&  schedule)
+          : m_id(id), m_schedule(schedule) {
+            bind([f, obj, &observers] { return std::invoke(f, obj, observers.observers<Filters>()...); });
+            ECS_NOT_FINAL_ONLY(countEntities<Filters...>(observers));
+        };
+
+        template<typename Result, typename... Filters>
         Function(ECS_FINAL_SWITCH(std::uint32_t, std::string_view) id, //
-                 void (*f)(OBSERVER(Filters)...),
-                 World& world)
-          : m_function([f, &world] { std::invoke(f, ObserverManager::observers<Filters>(world)...); }), m_id(id) {}
+                 Result (*f)(OBSERVER(Filters)...),
+                 ObserverManager& observers,
+                 const Schedule&  schedule)
+          : m_id(id), m_schedule(schedule) {
+            bind([f, &observers] { return std::invoke(f, observers.observers<Filters>()...); });
+            ECS_NOT_FINAL_ONLY(countEntities<Filters...>(observers));
+        }
 
         void operator()() const {
             ECS_PROFILER(ZoneScoped);
+            ECS_TRACE(ECS_FINAL_SWITCH("function", m_id), ECS_FINAL_SWITCH(m_id, 0));
+
+            detail::observer::RunScope run(m_runs++);
 
-            ECS_NOT_FINAL_ONLY(spdlog::stopwatch sw);
+            spdlog::stopwatch sw;
             std::invoke(m_function);
-            ECS_NOT_FINAL_ONLY(m_time = sw.elapsed());
+            m_time = sw.elapsed();
+
+            ECS_NOT_FINAL_ONLY(m_metrics.time.record(
+              static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_time).count())));
+            ECS_NOT_FINAL_ONLY(m_metrics.entities += m_count_entities());
+        }
+
+        std::uint32_t      update(Schedule::Duration dt) noexcept { return m_schedule.update(dt); }
+        std::uint32_t      runs() const noexcept { return m_schedule.runs(); }
+        bool               defer(std::uint32_t max_frames) noexcept { return m_schedule.defer(max_frames); }
+        bool               deferrable() const noexcept { return m_schedule.deferrable(); }
+        void               executed() noexcept { m_schedule.executed(); }
+        Schedule::Duration cost() const noexcept { return m_time; }
+        Phase              phase() const noexcept { return m_schedule.schedule().phase; }
+        std::uint32_t      observerKey() const noexcept { return ECS_FINAL_SWITCH(m_id, crc32::compute(m_id)); }
+
+        // coroutine is still running, so its observers have to be refreshed
+        bool suspended() const noexcept { return m_task && !m_task->done(); }
+
+        void resume(detail::task::WaitList& ready) const {
+            if (m_task) {
+                ECS_TRACE(ECS_FINAL_SWITCH("function", m_id), ECS_FINAL_SWITCH(m_id, 0));
+                detail::observer::RunScope run(m_runs ? m_runs - 1 : 0); // coroutine continues the last run
+                m_task->resume(ready);
+            }
         }
 
         ECS_FINAL_ONLY(operator std::uint32_t() const { return m_id; })
@@ -313,13 +492,170 @@ private:
         ECS_NOT_FINAL_ONLY(operator std::string() const { return {m_id.data(), m_id.size()}; })
         ECS_NOT_FINAL_ONLY(std::string_view name() const noexcept { return m_id; })
         ECS_NOT_FINAL_ONLY(double executionTime() const noexcept { return m_time.count(); })
+        ECS_NOT_FINAL_ONLY(FunctionMetrics& metrics() const noexcept { return m_metrics; })
+
+    private:
+#ifndef ECS_FINAL
+        template<typename... Filters>
+        void countEntities(ObserverManager& observers) {
+            m_metrics.name   = m_id;
+            m_count_entities = [&observers] { return (std::size_t{0} + ... + observers.observers<Filters>().size()); };
+        }
+#endif
+
+        template<typename Call>
+        void bind(Call&& call) {
+            if constexpr (std::is_void_v<std::invoke_result_t<Call>>) {
+                m_function = std::forward<Call>(call);
+            } else {
+                // start a new coroutine only when the previous one is finished
+                m_task     = std::make_shared<Task>();
+                m_function = [call = std::forward<Call>(call), task = m_task] {
+                    if (task->done()) {
+                        *task = call();
+                    }
+                };
+            }
+        }
 
     private:
         std::function<void(void)> m_function;
+        std::shared_ptr<Task>     m_task;
         ECS_FINAL_SWITCH(std::uint32_t, std::string_view) m_id;
-        ECS_NOT_FINAL_ONLY(mutable std::chrono::duration<double> m_time{});
+        detail::schedule::State    m_schedule;
+        mutable Schedule::Duration m_time{};
+        mutable std::uint64_t      m_runs = 0; // calls so far, `Observer::slice` takes the part from them
+
+        ECS_NOT_FINAL_ONLY(mutable FunctionMetrics m_metrics);
+        ECS_NOT_FINAL_ONLY(std::function<std::size_t(void)> m_count_entities);
     };
 
+    // keep functions sorted by phase, registration order inside the phase
+    void addFunction(Function&& function) {
+        auto pos = std::ranges::upper_bound(m_functions, function.phase(), std::less<>{}, &Function::phase);
+        m_functions.insert(pos, std::move(function));
+    }
+
+    void applyDeferred() {
+        ECS_PROFILER(ZoneScoped);
+
+        {
+            std::lock_guard _(m_deferred_mutex);
+            m_applying_commands.swap(m_deferred_commands);
+        }
+
+        for (const auto& command : m_applying_commands) {
+            command(m_world);
+        }
+        m_applying_commands.clear();
+    }
+
+    // one frame without the render sync of `exec`
+    void calculate() noexcept {
+        runFunctions();
+        maintain();
+    }
+
+    // functions of the frame and the commands and entities they left
+    void runFunctions() noexcept {
+        ECS_PROFILER(ZoneScoped);
+        ECS_TRACE("Registry::exec");
+
+        assert(m_init_callbacks.empty() && "all systems must be initialized");
+
+        m_observer_manager.sync();
+        detail::task::collect(m_waiting, m_resuming);
+
+        spdlog::stopwatch frame_sw;
+        m_frame_stats = {};
+
+        // critical functions run whatever the budget, so their cost is reserved for the rest of the frame
+        Schedule::Duration critical{};
+        for (const auto& function : m_functions) {
+            if (!function.deferrable()) {
+                critical += function.cost() * function.runs();
+            }
+        }
+
+        for (auto& function : m_functions) {
+            if (!function.runs()) {
+                function.resume(m_resuming); // coroutine started by an earlier run continues in the same place
+                continue;
+            }
+
+            // measured cost of the last run is used as an estimation
+            auto cost = function.cost() * function.runs();
+            if (!function.deferrable()) {
+                critical -= cost;
+            } else if (m_frame_budget > Schedule::Duration::zero() &&
+                       frame_sw.elapsed() + critical + cost > m_frame_budget &&
+                       function.defer(m_max_deferred_frames)) {
+                m_frame_stats.deferred_functions++;
+                m_frame_stats.deferred_runs += function.runs();
+                m_frame_stats.deferred_time += cost;
+                continue;
+            }
+
+            function.resume(m_resuming);
+            for (auto i = function.runs(); i; --i) {
+                function();
+            }
+            function.executed();
+        }
+        m_resuming.moveTo(m_waiting); // coroutines of the deferred functions
+
+        m_frame_stats.frame_time = frame_sw.elapsed();
+        ECS_NOT_FINAL_ONLY(m_frame_time.record(static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(m_frame_stats.frame_time).count())));
+
+        cleanup();
+        applyDeferred();
+        m_world.flush(); // destroy all removed entities at the end of the frame
+    }
+
+    // end of the frame, `step` calls it on the calling thread after the frames of all worlds
+    void maintain() noexcept {
+        ECS_PROFILER(ZoneScoped);
+
+        if (m_serializer.asyncPending()) [[unlikely]] {
+            m_serializer.capture(); // consistent state for the async saves
+        }
+
+        // optimize one storage every 64 frames, storages are taken in turn
+        if (m_frame % 64 == 0) {
+            m_world.optimize(m_optimize_storage++);
+        }
+        // one storage per frame is checked for unused memory
+        m_world.compact(m_compact_storage++, m_frame);
+    }
+
+    void publish(const RunStats& stats) {
+        std::lock_guard _(m_run_stats_mutex);
+        m_run_stats = stats;
+    }
+
+    std::chrono::steady_clock::duration elapsed() noexcept {
+        auto now = std::chrono::steady_clock::now();
+        auto dt  = m_frame ? now - m_last_prepare : std::chrono::steady_clock::duration::zero();
+
+        m_last_prepare = now;
+        return dt;
+    }
+
+    // starts the frame, the due observers are marked to be refreshed
+    void schedule(Schedule::Duration dt) noexcept {
+        ++m_frame;
+        m_world.advanceTick(); // changes made from now on are seen by the next refresh of the observers
+
+        // skip observers of functions which are not due this frame
+        m_observer_manager.resetDue();
+        for (auto& function : m_functions) {
+            if (function.update(dt) || function.suspended()) {
+                m_observer_manager.markDue(function.observerKey());
+            }
+        }
+    }
+
     void cleanup() noexcept {
         ECS_PROFILER(ZoneScoped);
 
@@ -330,14 +666,44 @@ private:
         }
     }
 
+    // sleep_until wakes up late by the scheduler slice, so the last `spin` is spent yielding
+    static void waitUntil(std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::duration spin) {
+        ECS_PROFILER(ZoneScoped);
+
+        if (auto wake = deadline - spin; std::chrono::steady_clock::now() < wake) {
+            std::this_thread::sleep_until(wake);
+        }
+        while (std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
 private:
     World&                                                  m_world;
+    detail::task::WaitList                                  m_waiting; // must outlive coroutines
+    detail::task::WaitList                                  m_resuming;
     std::vector<Function>                                   m_functions;
     std::queue<std::function<void(void)>>                   m_init_callbacks;
     std::queue<std::function<void(void)>>                   m_cleanup_callbacks;
     std::unordered_map<SystemID, std::unique_ptr<System>>   m_systems;
-    std::unordered_map<SystemID, std::vector<std::jthread>> m_parallel_jobs;
+    JobScheduler                                            m_jobs;
+    std::vector<std::function<void(World&)>>                m_deferred_commands;
+    std::vector<std::function<void(World&)>>                m_applying_commands;
     std::atomic_bool                                        m_frame_ready;
+    std::uint64_t                                           m_frame = 0;
+    std::size_t                                             m_optimize_storage = 0;
+    std::size_t                                             m_compact_storage  = 0;
+    std::chrono::steady_clock::time_point                   m_last_prepare;
+    Schedule::Duration                                      m_frame_budget{};
+    std::uint32_t                                           m_max_deferred_frames = 10;
+    FrameStats                                              m_frame_stats;
+    RunStats                                                m_run_stats; // guarded by `m_run_stats_mutex`
+    ECS_NOT_FINAL_ONLY(Histogram m_frame_time);
     Serializer                                              m_serializer;
     ObserverManager                                         m_observer_manager;
+
+    ECS_PROFILER(TracyLockable(std::mutex, m_deferred_mutex));
+    ECS_NO_PROFILER(std::mutex m_deferred_mutex);
+    ECS_PROFILER(mutable TracyLockable(std::mutex, m_run_stats_mutex));
+    ECS_NO_PROFILER(mutable std::mutex m_run_stats_mutex);
 };
\ No newline at end of file
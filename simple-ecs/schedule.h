@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+
+// Order of execution inside one frame. Functions of the same phase keep the registration order.
+enum class Phase : std::uint8_t {
+    PreUpdate,
+    Update,
+    PostUpdate,
+    Render,
+};
+
+
+// Deferrable functions can be postponed to the next frames when the frame budget is exceeded.
+enum class Priority : std::uint8_t {
+    Critical,
+    Deferrable,
+};
+
+
+// Scheduling metadata of a registered function.
+//
+//   Schedule{.every = 6}                                   // every 6th frame
+//   Schedule{.phase = Phase::PostUpdate, .interval = 100ms} // 10 Hz with catch-up
+struct Schedule {
+    using Duration = std::chrono::duration<double>;
+
+    Phase         phase        = Phase::Update;
+    std::uint32_t every        = 1;  // run every N frames
+    Duration      interval     = {}; // fixed time step, zero to disable
+    std::uint32_t max_catch_up = 4;  // max runs per frame when fixed time step is behind
+    Priority      priority     = Priority::Critical;
+};
+
+
+// Statistics of the last executed frame
+struct FrameStats {
+    Schedule::Duration frame_time{};
+    Schedule::Duration deferred_time{}; // estimated cost of deferred functions
+    std::uint32_t      deferred_functions = 0;
+    std::uint32_t      deferred_runs      = 0;
+};
+
+
+// Server loop of `Registry::run`. Frames are calculated every `tick` and get `tick` as the frame time, so the
+// simulation doesn't depend on the wall clock. A zero tick runs frames back to back with the measured frame time.
+struct RunConfig {
+    Schedule::Duration tick         = Schedule::Duration{1. / 60.};
+    std::uint32_t      max_catch_up = 4; // max ticks run back to back when the loop is behind, the rest are dropped
+    Schedule::Duration spin         = std::chrono::microseconds(200); // the end of the wait is spun, not slept
+    std::uint64_t      frames       = 0;                              // stop after N frames, zero to run until stop
+};
+
+// Statistics of `Registry::run` since it was started
+struct RunStats {
+    std::uint64_t      frames   = 0;
+    std::uint64_t      overruns = 0; // frames which took longer than a tick
+    std::uint64_t      dropped  = 0; // ticks skipped because the loop was more than `max_catch_up` ticks behind
+    Schedule::Duration max_overrun{};
+    Schedule::Duration busy{}; // time in frames
+    Schedule::Duration idle{}; // time between frames
+};
+
+
+namespace detail::schedule
+{
+
+// runtime state of the Schedule
+struct State final {
+    State(const Schedule& schedule) : m_schedule(schedule) {}
+
+    // returns how many times function should be executed in the current frame
+    std::uint32_t update(Schedule::Duration dt) noexcept {
+        m_runs = std::exchange(m_deferred, 0);
+
+        const bool fixed_step = m_schedule.interval > Schedule::Duration::zero();
+        if (++m_frames < std::max(m_schedule.every, 1U)) {
+            if (fixed_step) {
+                m_accumulator += dt; // time of the skipped frames is caught up on the next due frame
+            }
+            return m_runs;
+        }
+        m_frames = 0;
+
+        if (!fixed_step) {
+            m_runs = 1; // deferred runs of a per frame function are merged
+            return m_runs;
+        }
+
+        m_accumulator += dt;
+        while (m_accumulator >= m_schedule.interval && m_runs < m_schedule.max_catch_up) {
+            m_accumulator -= m_schedule.interval;
+            ++m_runs;
+        }
+
+        // we are too far behind, drop the rest to avoid spiral of death
+        if (m_accumulator >= m_schedule.interval) {
+            m_accumulator = Schedule::Duration::zero();
+        }
+
+        return m_runs;
+    }
+
+    // postpone runs of the current frame to the next one.
+    // returns false if function was deferred too many times in a row and must be executed now
+    bool defer(std::uint32_t max_deferred_frames) noexcept {
+        if (m_schedule.priority != Priority::Deferrable || m_deferred_frames >= max_deferred_frames) {
+            m_deferred_frames = 0;
+            return false;
+        }
+
+        ++m_deferred_frames;
+        m_deferred = std::min(m_runs, std::max(m_schedule.max_catch_up, 1U));
+        return true;
+    }
+
+    void executed() noexcept { m_deferred_frames = 0; }
+
+    const Schedule& schedule() const noexcept { return m_schedule; }
+    std::uint32_t   runs() const noexcept { return m_runs; }
+    bool            isDue() const noexcept { return m_runs != 0; }
+    bool            deferrable() const noexcept { return m_schedule.priority == Priority::Deferrable; }
+
+private:
+    Schedule           m_schedule;
+    Schedule::Duration m_accumulator{};
+    std::uint32_t      m_frames          = 0;
+    std::uint32_t      m_runs            = 0;
+    std::uint32_t      m_deferred        = 0;
+    std::uint32_t      m_deferred_frames = 0;
+};
+
+} // namespace detail::schedule
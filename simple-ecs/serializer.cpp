@@ -1,18 +1,21 @@
 #include "simple-ecs/serializer.h"
+#include "simple-ecs/tools/lz.h"
 
 #include <spdlog/spdlog.h>
 #include <spdlog/stopwatch.h>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <ranges>
+#include <tuple>
 
 
 namespace detail::serializer
 {
 
-static bool checkSaveLoadCallbacks(
-  const std::unordered_map<Component, std::function<void(Entity, ::serializer::Output&)>>& save_functions,
-  const std::unordered_map<Component, std::function<void(Entity, ::serializer::Input&)>>&  load_functions) {
+#ifndef NDEBUG
+static bool checkSaveLoadCallbacks(const std::unordered_map<Component, Serializer::Column>&       save_functions,
+                                   const std::unordered_map<Component, Serializer::Loader>&       load_functions) {
     if (save_functions.size() != load_functions.size()) {
         return false;
     }
@@ -22,62 +25,1140 @@ static bool checkSaveLoadCallbacks(
 
     return it == keys.end();
 }
+#endif
+
+Writer::Writer(::serializer::Sink sink, std::size_t chunk_size) : m_sink(std::move(sink)), m_chunk_size(chunk_size) {
+    assert(m_chunk_size && "Chunk size cannot be zero");
+    m_buffer.reserve(m_chunk_size);
+}
+
+std::uint32_t adler32(std::uint32_t adler, std::span<const ::serializer::Data> data) noexcept {
+    constexpr std::uint32_t MOD  = 65521;
+    constexpr std::size_t   NMAX = 5552; // the largest n such that sums don't overflow before the modulo
+
+    std::uint32_t a = adler & 0xFFFF;
+    std::uint32_t b = adler >> 16;
+    while (!data.empty()) {
+        auto part = data.first(std::min(data.size(), NMAX));
+        for (auto byte : part) {
+            a += static_cast<std::uint8_t>(byte);
+            b += a;
+        }
+        a %= MOD;
+        b %= MOD;
+        data = data.subspan(part.size());
+    }
+    return (b << 16) | a;
+}
+
+void encodeEntities(std::span<::serializer::Data> block, std::size_t count) noexcept {
+    Entity previous = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        Entity e = 0;
+        std::memcpy(&e, block.data() + i * sizeof(Entity), sizeof(Entity));
+
+        auto delta  = static_cast<std::int32_t>(e - previous);
+        auto zigzag = (static_cast<std::uint32_t>(delta) << 1) ^ static_cast<std::uint32_t>(delta >> 31);
+        std::memcpy(block.data() + i * sizeof(Entity), &zigzag, sizeof(Entity));
+        previous = e;
+    }
+}
+
+void decodeEntities(std::span<::serializer::Data> block, std::size_t count) noexcept {
+    Entity previous = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint32_t zigzag = 0;
+        std::memcpy(&zigzag, block.data() + i * sizeof(Entity), sizeof(Entity));
+
+        auto delta = (zigzag >> 1) ^ (0U - (zigzag & 1));
+        previous += delta;
+        std::memcpy(block.data() + i * sizeof(Entity), &previous, sizeof(Entity));
+    }
+}
+
+void Writer::write(const void* ptr, std::size_t size) {
+    const auto* bytes = static_cast<const ::serializer::Data*>(ptr);
+
+    if (m_in_block) {
+        m_block.insert(m_block.end(), bytes, bytes + size);
+        return;
+    }
+
+    m_offset += size;
+    if (m_section) {
+        m_checksum = adler32(m_checksum, {bytes, size});
+    }
+
+    // fill the current chunk
+    auto part = std::min(size, m_chunk_size - m_buffer.size());
+    m_buffer.insert(m_buffer.end(), bytes, bytes + part);
+    bytes += part;
+    size -= part;
+
+    if (m_buffer.size() < m_chunk_size) {
+        return;
+    }
+    flush();
+
+    // full chunks are passed without copy
+    for (; size >= m_chunk_size; bytes += m_chunk_size, size -= m_chunk_size) {
+        m_sink({bytes, m_chunk_size});
+    }
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+}
+
+void Writer::start() {
+    write(MAGIC);
+    write(VERSION);
+}
+
+void Writer::beginSection(IDType id, Section type, std::size_t count, ::serializer::Codec codec) {
+    endSection();
+
+    m_toc.emplace_back(id, type, codec, count, m_offset, 0, 0);
+    m_section  = true;
+    m_checksum = 1;
+    m_codec    = codec;
+
+    write(id);
+    write(type);
+    write(codec);
+    write(static_cast<Size>(count));
+}
+
+void Writer::beginBlock(std::size_t count, std::size_t bytes) {
+    assert(!m_in_block && "Previous block is not finished");
+
+    if (m_codec == ::serializer::Codec::None) {
+        write(static_cast<std::uint32_t>(count));
+        write(static_cast<std::uint32_t>(bytes));
+        return;
+    }
+
+    m_block.clear();
+    m_block.reserve(bytes);
+    m_block_count = count;
+    m_in_block    = true;
+}
+
+void Writer::endBlock() {
+    if (!m_in_block) {
+        return;
+    }
+    m_in_block = false;
+
+    encodeEntities(m_block, m_block_count);
+    m_compressed.clear();
+    lz::compress(m_block, m_compressed);
+
+    // incompressible block is stored as is, then its size is the raw size
+    const auto& data = m_compressed.size() < m_block.size() ? m_compressed : m_block;
+    write(static_cast<std::uint32_t>(m_block_count));
+    write(static_cast<std::uint32_t>(data.size()));
+    write(static_cast<std::uint32_t>(m_block.size()));
+    write(data.data(), data.size());
+}
+
+void Writer::endSection() {
+    if (!m_section) {
+        return;
+    }
+
+    auto& entry    = m_toc.back();
+    entry.size     = m_offset - entry.offset;
+    entry.checksum = m_checksum;
+    m_section      = false;
+}
+
+void Writer::finish() {
+    endSection();
+    write(END);
+
+    auto toc_offset = m_offset;
+    for (const auto& entry : m_toc) {
+        write(entry.id);
+        write(entry.type);
+        write(entry.codec);
+        write(entry.count);
+        write(entry.offset);
+        write(entry.size);
+        write(entry.checksum);
+    }
+
+    write(static_cast<std::uint64_t>(toc_offset));
+    write(static_cast<std::uint32_t>(m_toc.size()));
+    write(MAGIC);
+    flush();
+}
+
+void Writer::flush() {
+    if (!m_buffer.empty()) {
+        m_sink(m_buffer);
+        m_buffer.clear();
+    }
+}
+
+std::span<const ::serializer::Data> Reader::read(std::size_t size) {
+    if (!m_source) {
+        m_failed |= size > m_data.size();
+        size = std::min(size, m_data.size());
+        auto bytes = m_data.first(size);
+        m_data     = m_data.subspan(size);
+        m_offset += size;
+        return bytes;
+    }
+
+    if (m_buffer.size() - m_begin < size) {
+        // keep the unread tail and read the rest from the source
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_begin));
+        m_begin = 0;
+
+        // sizes come from the data, so the buffer grows with the data actually read
+        auto filled = m_buffer.size();
+        while (filled < size) {
+            auto capacity = std::max(2 * filled, ::serializer::CHUNK_SIZE);
+            m_buffer.resize(std::min(std::max(size, ::serializer::CHUNK_SIZE), capacity));
+            auto read = m_source(std::span(m_buffer).subspan(filled));
+            if (!read) {
+                break;
+            }
+            filled += read;
+        }
+        m_buffer.resize(filled);
+        m_failed |= filled < size;
+        size = std::min(size, filled);
+    }
+
+    auto bytes = std::span<const ::serializer::Data>(m_buffer).subspan(m_begin, size);
+    m_begin += size;
+    m_offset += size;
+    m_checksum = adler32(m_checksum, bytes);
+    return bytes;
+}
+
+bool Reader::eof() {
+    if (!m_source) {
+        return m_data.empty();
+    }
+    if (m_begin < m_buffer.size()) {
+        return false;
+    }
+
+    m_buffer.resize(::serializer::CHUNK_SIZE);
+    m_buffer.resize(m_source(m_buffer));
+    m_begin = 0;
+    return m_buffer.empty();
+}
+
+static bool readHeader(Reader& reader) {
+    auto header = reader.read(2 * sizeof(std::uint32_t));
+    if (header.size() != 2 * sizeof(std::uint32_t)) {
+        return false;
+    }
+
+    const auto* ptr     = header.data();
+    auto        magic   = ::serializer::deserialize<std::uint32_t>(ptr);
+    auto        version = ::serializer::deserialize<std::uint32_t>(ptr);
+    return magic == MAGIC && version == VERSION;
+}
+
+static TocEntry readTocEntry(Reader& reader) {
+    TocEntry entry{};
+    entry.id       = reader.read<IDType>();
+    entry.type     = reader.read<Section>();
+    entry.codec    = reader.read<::serializer::Codec>();
+    entry.count    = reader.read<Size>();
+    entry.offset   = reader.read<std::uint64_t>();
+    entry.size     = reader.read<std::uint64_t>();
+    entry.checksum = reader.read<std::uint32_t>();
+    return entry;
+}
+
+static bool validSection(const TocEntry& entry) {
+    return entry.type <= Section::Remove && entry.codec <= ::serializer::Codec::LZ;
+}
+
+// entry of the table describes the section, the checksum is compared when the section is loaded
+static bool sameSection(const TocEntry& lhs, const TocEntry& rhs) {
+    return lhs.id == rhs.id && lhs.type == rhs.type && lhs.codec == rhs.codec && lhs.count == rhs.count &&
+           lhs.offset == rhs.offset && lhs.size == rhs.size;
+}
+
+static bool readToc(std::span<const ::serializer::Data> data, std::vector<TocEntry>& toc) {
+    constexpr std::size_t ENTRY_SIZE = sizeof(IDType) + sizeof(Section) + sizeof(::serializer::Codec) + sizeof(Size) +
+                                       2 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+
+    if (data.size() < FOOTER_SIZE) {
+        return false;
+    }
+
+    const auto* footer  = data.last(FOOTER_SIZE).data();
+    auto        offset  = ::serializer::deserialize<std::uint64_t>(footer);
+    auto        entries = ::serializer::deserialize<std::uint32_t>(footer);
+    auto        magic   = ::serializer::deserialize<std::uint32_t>(footer);
+    if (magic != MAGIC || offset > data.size() - FOOTER_SIZE ||
+        entries > (data.size() - FOOTER_SIZE - offset) / ENTRY_SIZE) {
+        return false;
+    }
+
+    // the sections end with the end marker right before the table
+    if (offset < sizeof(IDType)) {
+        return false;
+    }
+    Reader end(data.subspan(offset - sizeof(IDType), sizeof(IDType)));
+    if (end.read<IDType>() != END) {
+        return false;
+    }
+
+    Reader reader(data.subspan(offset, entries * ENTRY_SIZE));
+    toc.resize(entries);
+    for (auto& entry : toc) {
+        entry = readTocEntry(reader);
+        if (!validSection(entry) || entry.offset > offset || entry.size > offset - entry.offset ||
+            entry.size < SECTION_HEADER_SIZE) {
+            return false;
+        }
+
+        // skipped sections are not verified by the checksum, so a flipped id would drop a column silently
+        Reader   header(data.subspan(entry.offset, SECTION_HEADER_SIZE));
+        TocEntry section{};
+        section.id     = header.read<IDType>();
+        section.type   = header.read<Section>();
+        section.codec  = header.read<::serializer::Codec>();
+        section.count  = header.read<Size>();
+        section.offset = entry.offset;
+        section.size   = entry.size;
+        if (!sameSection(entry, section)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stream is loaded before its table of contents is read, so the sections and their checksums are compared after.
+// The whole table is compared, so the stream is rejected if it couldn't be loaded from memory
+static bool checkToc(Reader& reader, std::span<const TocEntry> sections) {
+    const auto toc_offset = reader.offset();
+    for (const auto& section : sections) {
+        auto entry = readTocEntry(reader);
+        if (reader.failed() || !sameSection(entry, section)) {
+            spdlog::error("Table of contents doesn't match the sections");
+            return false;
+        }
+        if (entry.checksum != section.checksum) {
+            spdlog::error("Section of component {} is corrupted", entry.id);
+            return false;
+        }
+    }
+
+    auto offset  = reader.read<std::uint64_t>();
+    auto entries = reader.read<std::uint32_t>();
+    auto magic   = reader.read<std::uint32_t>();
+    if (reader.failed() || offset != toc_offset || entries != sections.size() || magic != MAGIC) {
+        spdlog::error("Table of contents doesn't match the sections");
+        return false;
+    }
+    return true;
+}
+
+// Count of the section comes from the data, so the memory reserved up front is limited by the data in memory.
+// Stream sections grow with the blocks actually read
+static std::size_t reserveCount(const Reader& reader, const TocEntry& entry) {
+    if (reader.buffered()) {
+        return std::min<std::size_t>(entry.count, ::serializer::CHUNK_SIZE / sizeof(Entity));
+    }
+
+    auto size = reader.data().size();
+    auto max  = entry.codec == ::serializer::Codec::None ? size : lz::maxDecompressed(size);
+    return std::min<std::size_t>(entry.count, max / sizeof(Entity));
+}
+
+struct BlockHeader {
+    std::uint32_t count;
+    std::uint32_t size;
+    std::uint32_t raw_size; // size of the decompressed block
+};
+
+// Sizes are checked before anything is allocated, `left` components of the section are not read yet
+static bool readBlockHeader(Reader& reader, Size left, ::serializer::Codec codec, BlockHeader& header) {
+    header.count    = reader.read<std::uint32_t>();
+    header.size     = reader.read<std::uint32_t>();
+    header.raw_size = codec == ::serializer::Codec::None ? header.size : reader.read<std::uint32_t>();
+
+    bool valid = !reader.failed() && header.count && header.count <= left &&
+                 header.raw_size >= std::uint64_t{header.count} * sizeof(Entity);
+    if (codec != ::serializer::Codec::None) {
+        // incompressible block is stored as is
+        valid &= header.size <= header.raw_size && header.raw_size <= lz::maxDecompressed(header.size);
+    }
+
+    if (!valid) {
+        spdlog::error("Block is corrupted, {} components are not loaded", left);
+    }
+    return valid;
+}
+
+static bool verify(const TocEntry& entry, std::span<const ::serializer::Data> section) {
+    if (adler32(1, section) == entry.checksum) {
+        return true;
+    }
+
+    spdlog::error("Section of component {} is corrupted", entry.id);
+    return false;
+}
 
 } // namespace detail::serializer
 
-Serializer::Serializer(World& world) : m_world(world) {};
+Serializer::Serializer(World& world, JobScheduler& jobs) : m_world(world), m_jobs(jobs) {
+    // ids of destroyed entities are reused, so pending columns and deltas must not refer to them anymore
+    m_world.subscribeDestroy([this](std::span<const Entity> ents) {
+        for (auto e : ents) {
+            if (e < m_saved.size() && m_saved[e] != detail::serializer::SKIPPED) {
+                m_loaded[m_saved[e]] = detail::serializer::SKIPPED;
+                m_saved[e]           = detail::serializer::SKIPPED;
+            }
+        }
+    });
+}
+
 
 serializer::Output Serializer::save() {
+    serializer::Output data;
+    save([&data](std::span<const serializer::Data> chunk) { data.insert(data.end(), chunk.begin(), chunk.end()); });
+    return data;
+}
+
+void Serializer::save(serializer::Sink sink, std::size_t chunk_size) {
     ECS_PROFILER(ZoneScoped);
+    ECS_TRACE("Serializer::save");
+
+    std::ignore = loadPending(); // columns of a lazy load are saved too
 
     assert(detail::serializer::checkSaveLoadCallbacks(m_save_functions, m_load_functions) &&
            "For each save function, you should have one load function");
 
-    spdlog::stopwatch  sw;
-    serializer::Output data;
+    spdlog::stopwatch sw;
+
+    // part of a column, parts are encoded in parallel and written in order
+    struct Part {
+        IDType                    id;
+        std::size_t               count; // elements in the section, header is written before the first part
+        serializer::Codec         codec;
+        const SaveFunction*       save;
+        detail::serializer::Range range;
+        serializer::Output        data;
+    };
+
+    SaveFunction save_entities = [this](detail::serializer::Writer& writer, detail::serializer::Range range) {
+        detail::serializer::writeBlocks(writer, m_world.entities(), range, 0, [](auto, auto) {});
+    };
 
-    for (auto entity : m_world.entities()) {
-        auto&& id = serializer::serialize(ct::ID<Component>);
-        std::ranges::copy(id, std::back_inserter(data));
-        for (const auto& func : std::views::values(m_save_functions)) {
-            std::invoke(func, entity, data);
+    // a part is about `chunk_size` bytes, so a batch of parts keeps the memory bounded whatever the components are
+    std::vector<Part> parts;
+    auto split = [this, &parts, chunk_size](IDType id, std::size_t count, std::size_t element, const SaveFunction& f) {
+        const auto part_size = std::clamp<std::size_t>(chunk_size / element, 1, detail::serializer::PART_SIZE);
+
+        // empty section is one empty part
+        for (std::size_t first = 0; first < count || first == 0; first += part_size) {
+            auto last = std::min(first + part_size, count);
+            parts.emplace_back(id, count, codec(id), &f, detail::serializer::Range{{}, first, last});
         }
+    };
+
+    split(ct::ID<Entity>, m_world.entities().size(), sizeof(Entity), save_entities);
+    for (const auto& [id, column] : m_save_functions) {
+        split(id, column.entities().size(), column.element, column.save);
     }
 
-    spdlog::info("Saved {:.3}", sw);
-    return data;
+    {
+        detail::serializer::Writer writer(std::move(sink), chunk_size);
+        writer.start();
+
+        // parts are encoded by batches, so only one batch of about `batch * chunk_size` bytes is kept in memory
+        const auto batch = (JobScheduler::thread_count + 1) * 2;
+
+        std::vector<std::function<void(void)>> tasks;
+        for (std::size_t first = 0; first < parts.size(); first += batch) {
+            auto last = std::min(first + batch, parts.size());
+
+            tasks.clear();
+            for (auto i = first; i < last; ++i) {
+                tasks.emplace_back([&part = parts[i], chunk_size] {
+                    ECS_TRACE("Serializer::savePart", part.id);
+                    detail::serializer::Writer part_writer(
+                      [&part](std::span<const serializer::Data> chunk) {
+                          part.data.insert(part.data.end(), chunk.begin(), chunk.end());
+                      },
+                      chunk_size);
+                    part_writer.setCodec(part.codec);
+                    std::invoke(*part.save, part_writer, part.range);
+                });
+            }
+            m_jobs.parallel(tasks);
+
+            for (auto i = first; i < last; ++i) {
+                auto& part = parts[i];
+                if (part.range.first == 0) {
+                    writer.beginSection(part.id, detail::serializer::Section::Insert, part.count, part.codec);
+                }
+                writer.write(part.data.data(), part.data.size());
+                serializer::Output().swap(part.data);
+            }
+        }
+        writer.finish();
+    }
+
+    spdlog::info("Saved {} parts in {:.3}", parts.size(), sw);
 }
 
+std::future<serializer::Output> Serializer::saveAsync() {
+    auto data    = std::make_shared<serializer::Output>();
+    auto promise = std::make_shared<std::promise<serializer::Output>>();
+    auto future  = promise->get_future();
+
+    std::lock_guard _(m_async_mutex);
+    m_async_saves.emplace_back(
+      [data](std::span<const serializer::Data> chunk) { data->insert(data->end(), chunk.begin(), chunk.end()); },
+      serializer::CHUNK_SIZE,
+      [data, promise](bool saved) { promise->set_value(saved ? std::move(*data) : serializer::Output{}); });
+    m_async_pending = true;
+    return future;
+}
+
+std::future<bool> Serializer::saveAsync(serializer::Sink sink, std::size_t chunk_size) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future  = promise->get_future();
+
+    std::lock_guard _(m_async_mutex);
+    m_async_saves.emplace_back(std::move(sink), chunk_size, [promise](bool saved) { promise->set_value(saved); });
+    m_async_pending = true;
+    return future;
+}
+
+void Serializer::finishAsync() {
+    std::vector<AsyncSave> requests;
+    {
+        std::lock_guard _(m_async_mutex);
+        requests.swap(m_async_saves);
+        m_async_pending = false;
+    }
+    if (!requests.empty()) {
+        spdlog::error("{} async saves are dropped, the registry is destroyed before the end of a frame",
+                      requests.size());
+    }
+    for (auto& request : requests) {
+        request.done(false);
+    }
+
+    for (auto running = m_async_running->load(); running; running = m_async_running->load()) {
+        m_async_running->wait(running);
+    }
+}
+
+void Serializer::capture() {
+    std::vector<AsyncSave> requests;
+    {
+        std::lock_guard _(m_async_mutex);
+        if (m_async_saves.empty()) [[likely]] {
+            return;
+        }
+        requests.swap(m_async_saves);
+        m_async_pending = false;
+    }
 
-void Serializer::load(std::span<const serializer::Data> data) {
     ECS_PROFILER(ZoneScoped);
+    ECS_TRACE("Serializer::capture");
+
+    std::ignore = loadPending(); // columns of a lazy load are saved too
 
     assert(detail::serializer::checkSaveLoadCallbacks(m_save_functions, m_load_functions) &&
            "For each save function, you should have one load function");
 
-    if (data.empty()) {
-        return;
+    spdlog::stopwatch sw;
+
+    struct Captured {
+        Component         id;
+        std::size_t       size;
+        serializer::Codec codec;
+        SaveFunction      save; // saves the copy
+    };
+
+    struct Snapshot {
+        std::vector<Entity>   entities;
+        serializer::Codec     entities_codec;
+        std::vector<Captured> columns;
+    };
+
+    auto snapshot            = std::make_shared<Snapshot>();
+    snapshot->entities       = m_world.entities();
+    snapshot->entities_codec = codec(ct::ID<Entity>);
+    snapshot->columns.reserve(m_save_functions.size());
+    for (const auto& [id, column] : m_save_functions) {
+        snapshot->columns.emplace_back(id, column.entities().size(), codec(id), column.capture());
     }
 
+    spdlog::info("Captured for async save {:.3}", sw);
+
+    ++*m_async_running;
+    m_jobs.post([snapshot, requests = std::move(requests), running = m_async_running]() mutable {
+        ECS_PROFILER(ZoneScopedN("Serializer::saveAsync"));
+        ECS_TRACE("Serializer::saveAsync");
+
+        spdlog::stopwatch sw;
+
+        for (auto& request : requests) {
+            {
+                detail::serializer::Writer writer(std::move(request.sink), request.chunk_size);
+                writer.start();
+
+                const auto& entities = snapshot->entities;
+                writer.beginSection(
+                  ct::ID<Entity>, detail::serializer::Section::Insert, entities.size(), snapshot->entities_codec);
+                detail::serializer::writeBlocks(writer, entities, {{}, 0, entities.size()}, 0, [](auto, auto) {});
+
+                for (const auto& [id, size, codec, save] : snapshot->columns) {
+                    writer.beginSection(id, detail::serializer::Section::Insert, size, codec);
+                    std::invoke(save, writer, detail::serializer::Range{{}, 0, size});
+                }
+                writer.finish();
+            }
+            request.done(true);
+        }
+
+        spdlog::info("Saved async {:.3}", sw);
+        if (--*running == 0) {
+            running->notify_all();
+        }
+    });
+}
+
+serializer::Output Serializer::saveDelta(serializer::Baseline& baseline) {
+    serializer::Output data;
+    saveDelta(baseline,
+              [&data](std::span<const serializer::Data> chunk) {
+                  data.insert(data.end(), chunk.begin(), chunk.end());
+              });
+    return data;
+}
+
+void Serializer::saveDelta(serializer::Baseline& baseline, serializer::Sink sink, std::size_t chunk_size) {
+    ECS_PROFILER(ZoneScoped);
+    ECS_TRACE("Serializer::saveDelta");
+
+    std::ignore = loadPending(); // columns of a lazy load are saved too
+
+    assert(detail::serializer::checkSaveLoadCallbacks(m_save_functions, m_load_functions) &&
+           "For each save function, you should have one load function");
+
     spdlog::stopwatch sw;
 
-    const auto* ptr = data.data();
+    const auto& entities = m_world.entities();
+
+    auto destroyed = TMP_GET(std::vector<Entity>);
+    auto created   = TMP_GET(std::vector<Entity>);
+    std::ranges::set_difference(baseline.entities, entities, std::back_inserter(*destroyed));
+    std::ranges::set_difference(entities, baseline.entities, std::back_inserter(*created));
 
-    Entity entity = 0;
-    do {
-        auto comp_id = *std::launder(reinterpret_cast<const IDType*>(ptr));
-        ptr += sizeof(IDType);
+    std::size_t changed = 0;
+    {
+        using detail::serializer::Section;
+        detail::serializer::Writer writer(std::move(sink), chunk_size);
+        writer.start();
 
-        if (ct::ID<Entity> == comp_id) {
-            entity = m_world.create();
-            continue;
+        if (!destroyed->empty()) {
+            writer.beginSection(ct::ID<Entity>, Section::Remove, destroyed->size(), codec(ct::ID<Entity>));
+            detail::serializer::writeBlocks(writer, *destroyed, {{}, 0, destroyed->size()}, 0, [](auto, auto) {});
         }
+        if (!created->empty()) {
+            writer.beginSection(ct::ID<Entity>, Section::Insert, created->size(), codec(ct::ID<Entity>));
+            detail::serializer::writeBlocks(writer, *created, {{}, 0, created->size()}, 0, [](auto, auto) {});
+        }
+
+        auto lost    = TMP_GET(std::vector<Entity>);
+        auto removed = TMP_GET(std::vector<Entity>);
+        auto indices = TMP_GET(std::vector<std::uint32_t>);
+        for (const auto& [id, column] : m_save_functions) {
+            auto        ticks    = column.ticks();
+            const auto& current  = column.sorted();
+            auto&       previous = baseline.components[id];
+
+            indices->clear();
+            for (std::size_t i = 0; i < ticks.size(); ++i) {
+                if (ticks[i] >= baseline.tick) {
+                    indices->emplace_back(static_cast<std::uint32_t>(i));
+                }
+            }
 
-        auto it = m_load_functions.find(comp_id);
-        if (it != m_load_functions.end()) {
-            std::invoke(it->second, entity, ptr);
+            // components of the destroyed entities are removed with them
+            lost->clear();
+            removed->clear();
+            std::ranges::set_difference(previous, current, std::back_inserter(*lost));
+            std::ranges::set_difference(*lost, *destroyed, std::back_inserter(*removed));
+
+            if (!removed->empty()) {
+                writer.beginSection(id, Section::Remove, removed->size(), codec(id));
+                detail::serializer::writeBlocks(writer, *removed, {{}, 0, removed->size()}, 0, [](auto, auto) {});
+            }
+            if (!indices->empty()) {
+                writer.beginSection(id, Section::Insert, indices->size(), codec(id));
+                std::invoke(column.save, writer, detail::serializer::Range{*indices, 0, indices->size()});
+            }
+
+            changed += removed->size() + indices->size();
+            previous.assign(current.begin(), current.end());
         }
-    } while (ptr - data.data() < data.size()); // NOLINT
+        writer.finish();
+    }
+
+    // the tick isn't advanced, changes made later in the same tick are saved again by the next delta
+    baseline.tick     = m_world.tick();
+    baseline.entities = entities;
+
+    spdlog::info("Saved delta in {:.3}: {} created, {} destroyed, {} components changed",
+                 sw,
+                 created->size(),
+                 destroyed->size(),
+                 changed);
+}
+
+
+bool Serializer::load(std::span<const serializer::Data> data, std::span<const Component> only) {
+    ECS_PROFILER(ZoneScoped);
+
+    spdlog::stopwatch sw;
+
+    closeMapped();
+    detail::serializer::Reader reader(data);
+    if (!loadSections(reader, only, false, false, false)) {
+        return false;
+    }
+
+    spdlog::info("Loaded {:.3}", sw);
+    return true;
+}
+
+bool Serializer::load(serializer::Source source, std::span<const Component> only) {
+    ECS_PROFILER(ZoneScoped);
+
+    spdlog::stopwatch sw;
+
+    closeMapped();
+    detail::serializer::Reader reader(std::move(source));
+    if (!loadSections(reader, only, false, false, false)) {
+        return false;
+    }
 
     spdlog::info("Loaded {:.3}", sw);
+    return true;
+}
+
+bool Serializer::load(const std::filesystem::path& path, std::span<const Component> only, serializer::LoadMode mode) {
+    ECS_PROFILER(ZoneScoped);
+
+    spdlog::stopwatch sw;
+
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    closeMapped();
+    m_mapped = std::move(file);
+
+    detail::serializer::Reader reader(m_mapped.data());
+    bool                       lazy   = mode == serializer::LoadMode::Lazy;
+    bool                       loaded = loadSections(reader, only, true, lazy, false);
+    if (m_pending.empty()) {
+        closeMapped();
+    }
+
+    if (loaded) {
+        spdlog::info("Loaded {} in {:.3}, {} columns are pending", path.string(), sw, m_pending.size());
+    }
+    return loaded;
+}
+
+bool Serializer::loadDelta(std::span<const serializer::Data> data) {
+    ECS_PROFILER(ZoneScoped);
+
+    spdlog::stopwatch sw;
+
+    std::ignore = loadPending(); // delta is applied on top of the loaded columns
+    assert(m_pending.empty() && "Delta can't be applied while the columns of the snapshot are pending");
+
+    detail::serializer::Reader reader(data);
+    if (!loadSections(reader, {}, false, false, true)) {
+        return false;
+    }
+
+    spdlog::info("Loaded delta {:.3}", sw);
+    return true;
+}
+
+bool Serializer::loadSections(detail::serializer::Reader& reader,
+                              std::span<const Component>  only,
+                              bool                        keep_pending,
+                              bool                        lazy,
+                              bool                        is_delta) {
+    ECS_PROFILER(ZoneScoped);
+    ECS_TRACE("Serializer::load");
+
+    using detail::serializer::Section;
+
+    assert(detail::serializer::checkSaveLoadCallbacks(m_save_functions, m_load_functions) &&
+           "For each save function, you should have one load function");
+
+    // in memory the sections are found by the table of contents, stream is read in order
+    auto                                      data = reader.data();
+    std::vector<detail::serializer::TocEntry> toc;
+    if (!detail::serializer::readHeader(reader) || (!reader.buffered() && !detail::serializer::readToc(data, toc))) {
+        spdlog::error("Data is not a snapshot of version {}", detail::serializer::VERSION);
+        return false;
+    }
+
+    // delta refers to the entities of the previous load, full snapshot starts from scratch
+    if (!is_delta) {
+        m_pending.clear();
+        m_loaded.clear();
+        m_saved.clear();
+    }
+
+    // saved entities are collected and created at once
+    LoadFunction read_entities = [](std::span<const serializer::Data> block,
+                                    std::size_t                       count,
+                                    std::span<const Entity>,
+                                    std::vector<Entity>& saved) {
+        auto size = saved.size();
+        saved.resize(size + count);
+        std::memcpy(saved.data() + size, block.data(), count * sizeof(Entity));
+        if (auto last = *std::ranges::max_element(std::span(saved).subspan(size));
+            last >= detail::serializer::MAX_SAVED_ENTITY) {
+            spdlog::error("Saved entity {} is out of range", last);
+            return false;
+        }
+        return true;
+    };
+    LoadFunction destroy_entities = [this](std::span<const serializer::Data> block,
+                                           std::size_t                       count,
+                                           std::span<const Entity>,
+                                           std::vector<Entity>& /*unused*/) {
+        serializer::Input data = block.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            auto saved = serializer::deserialize<Entity>(data);
+            if (saved >= m_loaded.size()) {
+                spdlog::error("Destroyed entity {} is not in the entity table", saved);
+                return false;
+            }
+            if (m_loaded[saved] != detail::serializer::SKIPPED) {
+                m_world.destroy(m_loaded[saved]);
+                m_saved[m_loaded[saved]] = detail::serializer::SKIPPED;
+            }
+            m_loaded[saved] = detail::serializer::SKIPPED;
+        }
+        return true;
+    };
+
+    auto load_entities = [this, &read_entities, &destroy_entities](detail::serializer::Reader&         blocks,
+                                                                     const detail::serializer::TocEntry& entry) {
+        auto saved = TMP_GET(std::vector<Entity>);
+        if (entry.type == Section::Remove) {
+            return loadBlocks(blocks, entry.count, entry.codec, destroy_entities, *saved);
+        }
+
+        saved->reserve(detail::serializer::reserveCount(blocks, entry));
+        if (!loadBlocks(blocks, entry.count, entry.codec, read_entities, *saved)) {
+            return false;
+        }
+        createEntities(*saved);
+        return true;
+    };
+
+    // Blocks in memory stay valid, so columns are collected and loaded in parallel, one task per storage.
+    // User callbacks may read any storage, so they are run on the calling thread: storages with destroy callbacks
+    // are loaded after the parallel ones, construct callbacks are deferred until all storages are loaded.
+    // Stream reuses its buffer, so it's loaded in order
+    std::unordered_map<Component, std::vector<const detail::serializer::TocEntry*>> columns; // sections in order
+
+    auto load_columns = [this, &columns, data] {
+        std::atomic<bool>                      loaded = true;
+        std::vector<std::function<void(void)>> tasks;
+        std::vector<std::function<void(void)>> serial;
+        tasks.reserve(columns.size());
+        for (const auto& [id, entries] : columns) {
+            const auto& loader = m_load_functions.at(id);
+            loader.defer(true);
+            auto& queue = loader.serial() ? serial : tasks;
+            queue.emplace_back([this, &entries, &loaded, data] {
+                for (const auto* entry : entries) {
+                    auto section = data.subspan(entry->offset, entry->size);
+                    if (!detail::serializer::verify(*entry, section)) {
+                        loaded.store(false, std::memory_order_relaxed);
+                        return;
+                    }
+
+                    detail::serializer::Reader column_reader(section.subspan(detail::serializer::SECTION_HEADER_SIZE));
+                    if (!loadColumn(column_reader, *entry)) {
+                        loaded.store(false, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+            });
+        }
+        m_jobs.parallel(tasks);
+        for (const auto& task : serial) {
+            task();
+        }
+        for (auto id : std::views::keys(columns)) {
+            m_load_functions.at(id).defer(false);
+        }
+        columns.clear();
+        flushNotify();
+        return loaded.load(std::memory_order_relaxed);
+    };
+
+    auto wanted = [only](IDType id) {
+        return only.empty() || id == ct::ID<Entity> || std::ranges::find(only, id) != only.end();
+    };
+
+    // `in_memory` section is found by the table of contents, otherwise blocks are read from the stream
+    auto load_section = [&](const detail::serializer::TocEntry& entry, bool in_memory) {
+        auto id       = entry.id;
+        bool loadable = entry.type == Section::Insert ? m_load_functions.contains(id) : m_remove_functions.contains(id);
+
+        if (in_memory) {
+            // unused sections are not even touched
+            if (id == ct::ID<Entity>) {
+                auto section = data.subspan(entry.offset, entry.size);
+                if (!detail::serializer::verify(entry, section)) {
+                    return false;
+                }
+
+                // columns refer to the entities loaded before
+                detail::serializer::Reader blocks(section.subspan(detail::serializer::SECTION_HEADER_SIZE));
+                return load_columns() && load_entities(blocks, entry);
+            } else if (!wanted(id)) {
+                return true;
+            } else if (loadable && !lazy) {
+                columns[id].emplace_back(&entry);
+            } else if (keep_pending && entry.type == Section::Insert) {
+                // mapped file stays open, so the sections stay valid
+                m_pending.emplace(id, Pending{data.subspan(entry.offset, entry.size), entry});
+            } else {
+                spdlog::warn("Skipped unknown component {}", id);
+            }
+            return true;
+        }
+
+        if (id == ct::ID<Entity>) {
+            return load_entities(reader, entry);
+        }
+        if (wanted(id) && loadable) {
+            return loadColumn(reader, entry);
+        }
+        if (wanted(id)) {
+            spdlog::warn("Skipped unknown component {}", id);
+        }
+        return skipBlocks(reader, entry.count, entry.codec);
+    };
+
+    bool loaded = true;
+    if (reader.buffered()) {
+        // checksums of the sections are collected while they are read
+        for (;;) {
+            reader.resetChecksum();
+            detail::serializer::TocEntry entry{};
+            entry.offset = reader.offset();
+            entry.id     = reader.read<IDType>();
+            if (!reader.failed() && entry.id == detail::serializer::END) {
+                break;
+            }
+            entry.type  = reader.read<Section>();
+            entry.codec = reader.read<serializer::Codec>();
+            entry.count = reader.read<detail::serializer::Size>();
+            if (reader.failed() || !detail::serializer::validSection(entry) || !load_section(entry, false)) {
+                spdlog::error("Stream is truncated or corrupted");
+                loaded = false;
+                break;
+            }
+            entry.size     = reader.offset() - entry.offset;
+            entry.checksum = reader.checksum();
+            toc.emplace_back(entry);
+        }
+        loaded = loaded && detail::serializer::checkToc(reader, toc);
+    } else {
+        for (const auto& entry : toc) {
+            if (!load_section(entry, true)) {
+                loaded = false;
+                break;
+            }
+        }
+    }
+
+    return loaded && load_columns();
+}
+
+void Serializer::createEntities(std::span<const Entity> saved) {
+    if (saved.empty()) {
+        return;
+    }
+
+    auto created = TMP_GET(std::vector<Entity>);
+    created->resize(saved.size());
+    m_world.create(*created);
+
+    auto last = *std::ranges::max_element(saved);
+    if (last >= m_loaded.size()) {
+        m_loaded.resize(last + 1, detail::serializer::SKIPPED);
+    }
+    auto last_created = *std::ranges::max_element(*created);
+    if (last_created >= m_saved.size()) {
+        m_saved.resize(last_created + 1, detail::serializer::SKIPPED);
+    }
+    for (std::size_t i = 0; i < saved.size(); ++i) {
+        m_loaded[saved[i]]     = (*created)[i];
+        m_saved[(*created)[i]] = saved[i];
+    }
+}
+
+bool Serializer::loadColumn(detail::serializer::Reader& reader, const detail::serializer::TocEntry& entry) {
+    ECS_TRACE("Serializer::loadColumn", entry.id);
+
+    auto added = TMP_GET(std::vector<Entity>);
+    if (entry.type == detail::serializer::Section::Remove) {
+        return loadBlocks(reader, entry.count, entry.codec, m_remove_functions.at(entry.id), *added);
+    }
+
+    const auto& loader = m_load_functions.at(entry.id);
+    auto reserve = detail::serializer::reserveCount(reader, entry);
+    loader.reserve(reserve);
+    added->reserve(reserve);
+    bool loaded = loadBlocks(reader, entry.count, entry.codec, loader.load, *added);
+    loader.finish(*added); // components loaded before the error are kept
+    return loaded;
+}
+
+bool Serializer::loadBlocks(detail::serializer::Reader& reader,
+                            detail::serializer::Size    count,
+                            serializer::Codec           codec,
+                            const LoadFunction&         load,
+                            std::vector<Entity>&        added) {
+    auto raw = TMP_GET(serializer::Output);
+
+    for (detail::serializer::Size loaded = 0; loaded < count;) {
+        detail::serializer::BlockHeader header{};
+        if (!detail::serializer::readBlockHeader(reader, count - loaded, codec, header)) {
+            return false;
+        }
+
+        auto block = reader.read(header.size);
+        if (reader.failed()) {
+            spdlog::error("Unexpected end of the data, {} components are not loaded", count - loaded);
+            return false;
+        }
+
+        if (codec != serializer::Codec::None) {
+            raw->resize(header.raw_size);
+            if (header.size == header.raw_size) {
+                std::ranges::copy(block, raw->begin());
+            } else if (!lz::decompress(block, *raw)) {
+                spdlog::error("Block is corrupted, {} components are not loaded", count - loaded);
+                return false;
+            }
+            detail::serializer::decodeEntities(*raw, header.count);
+            block = *raw;
+        }
+
+        if (!std::invoke(load, block, header.count, m_loaded, added)) {
+            return false;
+        }
+        loaded += header.count;
+    }
+    return true;
+}
+
+bool Serializer::skipBlocks(detail::serializer::Reader& reader,
+                            detail::serializer::Size    count,
+                            serializer::Codec           codec) {
+    for (detail::serializer::Size skipped = 0; skipped < count;) {
+        detail::serializer::BlockHeader header{};
+        if (!detail::serializer::readBlockHeader(reader, count - skipped, codec, header)) {
+            return false;
+        }
+
+        reader.read(header.size);
+        if (reader.failed()) {
+            spdlog::error("Unexpected end of the data");
+            return false;
+        }
+        skipped += header.count;
+    }
+    return true;
+}
+
+serializer::Codec Serializer::codec(Component id) const {
+    auto it = m_codecs.find(id);
+    return it == m_codecs.end() ? m_codec : it->second;
+}
+
+bool Serializer::loadPending(Component id) {
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        return true;
+    }
+    if (!m_load_functions.contains(id)) {
+        return false;
+    }
+
+    ECS_PROFILER(ZoneScoped);
+    ECS_TRACE("Serializer::loadPending", id);
+
+    // entities destroyed after the load were removed from m_loaded by the destroy subscription
+    auto pending = it->second;
+    m_pending.erase(it);
+
+    bool loaded = detail::serializer::verify(pending.entry, pending.section);
+    if (loaded) {
+        detail::serializer::Reader reader(pending.section.subspan(detail::serializer::SECTION_HEADER_SIZE));
+        loaded = loadColumn(reader, pending.entry);
+        if (!loaded) {
+            spdlog::error("Pending column of component {} is not fully loaded", id);
+        }
+        flushNotify();
+    }
+
+    if (m_pending.empty()) {
+        closeMapped();
+    }
+    return loaded;
+}
+
+void Serializer::closeMapped() {
+    // pending sections point into the mapping, they are dropped with it even if the next load fails
+    m_pending.clear();
+    m_mapped.close();
+}
+
+bool Serializer::loadPending() {
+    auto ids = TMP_GET(std::vector<Component>);
+    for (auto id : std::views::keys(m_pending)) {
+        if (m_load_functions.contains(id)) {
+            ids->emplace_back(id);
+        }
+    }
+
+    bool loaded = true;
+    for (auto id : *ids) {
+        loaded &= loadPending(id);
+    }
+    return loaded;
+}
+
+void Serializer::deferNotify(std::span<const Entity> ents) {
+    std::lock_guard _(m_notify_mutex);
+    m_notify.insert(m_notify.end(), ents.begin(), ents.end());
+}
+
+void Serializer::flushNotify() {
+    m_world.notify(m_notify);
+    m_notify.clear();
 }
@@ -1,9 +1,22 @@
 #pragma once
 
+#include "simple-ecs/job_scheduler.h"
+#include "simple-ecs/tools/mapped_file.h"
 #include "simple-ecs/world.h"
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
 
 
 namespace serializer
@@ -12,6 +25,20 @@ namespace serializer
 using Data   = char;
 using Output = std::vector<Data>;
 using Input  = const Data*;
+using Sink   = std::function<void(std::span<const Data>)>;
+using Source = std::function<std::size_t(std::span<Data>)>; // fills the buffer and returns size, 0 at the end
+
+constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+enum class Codec : std::uint8_t {
+    None,
+    LZ, // entity ids are delta coded and blocks are compressed by the LZ codec
+};
+
+enum class LoadMode : std::uint8_t {
+    Eager, // columns with a registered loader are loaded by `load`
+    Lazy,  // only the entities are loaded, columns stay mapped until `loadPending`
+};
 
 
 template<typename Type>
@@ -35,27 +62,505 @@ requires std::is_trivially_copyable_v<Type>
     return *reinterpret_cast<Type*>(std::launder(buffer.data()));
 }
 
+// Appends straight to the block of the snapshot, so custom savers don't need temporary buffers
+class OutputView final {
+public:
+    explicit OutputView(Output& data) noexcept : m_data(data) {}
+
+    void writeBytes(std::span<const Data> bytes) { m_data.insert(m_data.end(), bytes.begin(), bytes.end()); }
+
+    template<typename Type>
+    requires std::is_trivially_copyable_v<Type>
+    void write(const Type& value) {
+        writeBytes({reinterpret_cast<const Data*>(&value), sizeof(Type)});
+    }
+
+    // `[size][elements]`
+    template<std::ranges::contiguous_range Range>
+    requires std::is_trivially_copyable_v<std::ranges::range_value_t<Range>>
+    void writeSpan(const Range& values) {
+        auto size = std::ranges::size(values);
+        write(static_cast<std::uint64_t>(size));
+        writeBytes({reinterpret_cast<const Data*>(std::ranges::data(values)),
+                    size * sizeof(std::ranges::range_value_t<Range>)});
+    }
+
+    void writeString(std::string_view str) { writeSpan(str); }
+
+private:
+    Output& m_data;
+};
+
+// Bounds checked cursor over the block of the snapshot. Reading past the end returns empty values
+// and fails the view, then the rest of the block is not loaded
+class InputView final {
+public:
+    explicit InputView(std::span<const Data> data) noexcept : m_data(data) {}
+
+    std::span<const Data> readBytes(std::size_t size) noexcept {
+        if (m_failed || size > m_data.size()) {
+            m_failed = true;
+            return {};
+        }
+
+        auto bytes = m_data.first(size);
+        m_data     = m_data.subspan(size);
+        return bytes;
+    }
+
+    template<typename Type>
+    requires std::is_trivially_copyable_v<Type> && std::is_default_constructible_v<Type>
+    [[nodiscard]] Type read() noexcept {
+        Type value{};
+        auto bytes = readBytes(sizeof(Type));
+        if (!bytes.empty()) {
+            std::memcpy(&value, bytes.data(), sizeof(Type));
+        }
+        return value;
+    }
+
+    // reads `[size][elements]` written by `writeSpan` into a resizable container
+    template<typename Container>
+    requires std::is_trivially_copyable_v<std::ranges::range_value_t<Container>>
+    bool readSpan(Container& values) {
+        using Type = std::ranges::range_value_t<Container>;
+
+        auto size = read<std::uint64_t>();
+        if (size > m_data.size() / sizeof(Type)) {
+            m_failed = true;
+        }
+
+        auto bytes = readBytes(m_failed ? 0 : size * sizeof(Type));
+        values.resize(bytes.size() / sizeof(Type));
+        if (!bytes.empty()) {
+            std::memcpy(std::ranges::data(values), bytes.data(), bytes.size());
+        }
+        return !m_failed;
+    }
+
+    // string is not copied, it points into the block and is valid while the component is loaded
+    [[nodiscard]] std::string_view readString() noexcept {
+        auto size  = read<std::uint64_t>();
+        auto bytes = readBytes(size);
+        return {bytes.data(), bytes.size()};
+    }
+
+    bool  good() const noexcept { return !m_failed; }
+    Input position() const noexcept { return m_data.data(); }
+
+private:
+    std::span<const Data> m_data;
+    bool                  m_failed = false;
+};
+
 }; // namespace serializer
 
+
+namespace detail::serializer
+{
+
+using Size = std::uint64_t;
+
+// saved entity which was not loaded or was destroyed before its column was loaded
+constexpr Entity SKIPPED = std::numeric_limits<Entity>::max();
+
+// the table from the saved entities to the loaded ones is indexed by id, larger ids are treated as corrupted data
+constexpr Entity MAX_SAVED_ENTITY = Entity{1} << 28;
+
+// max elements in one part of a column, parts are encoded in parallel. Parts are also limited by `chunk_size` bytes
+constexpr std::size_t PART_SIZE = 64 * 1024;
+
+constexpr std::uint32_t MAGIC   = 0x53434553; // "SECS"
+constexpr std::uint32_t VERSION = 2;
+
+// marks the end of the sections for the stream, table of contents follows it
+constexpr IDType END = std::numeric_limits<IDType>::max();
+
+enum class Section : std::uint8_t {
+    Insert, // entities are created, components are added or replaced
+    Remove, // entities are destroyed, components are removed
+};
+
+constexpr std::size_t SECTION_HEADER_SIZE =
+  sizeof(IDType) + sizeof(Section) + sizeof(::serializer::Codec) + sizeof(Size);
+constexpr std::size_t FOOTER_SIZE         = sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t);
+
+// Section in the table of contents. Offset and size include the section header
+struct TocEntry {
+    IDType              id;
+    Section             type;
+    ::serializer::Codec codec;
+    Size                count;
+    std::uint64_t       offset;
+    std::uint64_t       size;
+    std::uint32_t       checksum; // adler32 of the section
+};
+
+std::uint32_t adler32(std::uint32_t adler, std::span<const ::serializer::Data> data) noexcept;
+
+// Entity ids of the block are replaced by zigzag coded deltas. Ids are mostly sorted,
+// so deltas are small and repeat, and the LZ codec finds them
+void encodeEntities(std::span<::serializer::Data> block, std::size_t count) noexcept;
+void decodeEntities(std::span<::serializer::Data> block, std::size_t count) noexcept;
+
+// Buffers the output and passes it to the sink by chunks of the same size. The last chunk can be smaller.
+// Snapshot is `[magic][version]`, sections, `[END]`, table of contents and `[toc offset][entries][magic]`.
+// Compressed block is collected between `beginBlock` and `endBlock`, and written as `[count][size][raw size][data]`
+struct Writer final : NoCopyNoMove {
+    Writer(::serializer::Sink sink, std::size_t chunk_size);
+    ~Writer() { flush(); }
+
+    void write(const void* ptr, std::size_t size);
+
+    template<typename Type>
+    requires std::is_trivially_copyable_v<Type>
+    void write(const Type& obj) {
+        write(&obj, sizeof(Type));
+    }
+
+    void flush();
+
+    // snapshot layout, parts of the sections written separately don't use it
+    void start();
+    // the previous section is over
+    void beginSection(IDType              id,
+                      Section             type,
+                      std::size_t         count,
+                      ::serializer::Codec codec = ::serializer::Codec::None);
+    void finish();
+
+    // block is `count` entities followed by their components, `bytes` in total if it's known
+    void beginBlock(std::size_t count, std::size_t bytes);
+    void endBlock();
+
+    void setCodec(::serializer::Codec codec) noexcept { m_codec = codec; }
+
+    std::size_t chunkSize() const noexcept { return m_chunk_size; }
+
+private:
+    void endSection();
+
+private:
+    ::serializer::Sink    m_sink;
+    ::serializer::Output  m_buffer;
+    std::size_t           m_chunk_size;
+    std::uint64_t         m_offset   = 0;
+    std::uint32_t         m_checksum = 1;
+    bool                  m_section  = false;
+    std::vector<TocEntry> m_toc;
+    ::serializer::Codec   m_codec       = ::serializer::Codec::None;
+    std::size_t           m_block_count = 0;
+    bool                  m_in_block    = false;
+    ::serializer::Output  m_block; // raw block to compress
+    ::serializer::Output  m_compressed;
+};
+
+// Reads the data by blocks. Data in memory is returned without copy, stream is read through the buffer which is
+// not bigger than the largest block
+struct Reader final : NoCopyNoMove {
+    explicit Reader(std::span<const ::serializer::Data> data) : m_data(data) {}
+    explicit Reader(::serializer::Source source) : m_source(std::move(source)) {}
+
+    // returns `size` bytes which are valid until the next call, fewer if the data is over
+    std::span<const ::serializer::Data> read(std::size_t size);
+
+    // value-initialized object if the data is over
+    template<typename Type>
+    requires std::is_trivially_copyable_v<Type>
+    Type read() {
+        auto bytes = read(sizeof(Type));
+        if (bytes.size() != sizeof(Type)) {
+            return Type{};
+        }
+        auto* ptr = bytes.data();
+        return ::serializer::deserialize<Type>(ptr);
+    }
+
+    bool eof();
+
+    // a read got less data than requested
+    bool failed() const noexcept { return m_failed; }
+
+    // stream is read through the buffer, so the returned data is valid only until the next read
+    bool buffered() const noexcept { return static_cast<bool>(m_source); }
+
+    // unread data in memory
+    std::span<const ::serializer::Data> data() const noexcept { return m_data; }
+
+    // bytes read so far, the offsets of the stream sections are compared with the table of contents
+    std::uint64_t offset() const noexcept { return m_offset; }
+
+    // adler32 of the stream read since the reset, stream sections are checked by the table of contents at the end
+    void          resetChecksum() noexcept { m_checksum = 1; }
+    std::uint32_t checksum() const noexcept { return m_checksum; }
+
+private:
+    std::span<const ::serializer::Data> m_data;
+    ::serializer::Source                m_source;
+    ::serializer::Output                m_buffer;
+    std::size_t                         m_begin    = 0;
+    std::uint64_t                       m_offset   = 0;
+    std::uint32_t                       m_checksum = 1;
+    bool                                m_failed   = false;
+};
+
+// Selected elements [first, last) of `indices`, or of the dense arrays if `indices` are empty
+struct Range {
+    std::span<const std::uint32_t> indices;
+    std::size_t                    first = 0;
+    std::size_t                    last  = 0;
+
+    // index of the dense arrays for the selected element
+    std::size_t operator[](std::size_t i) const noexcept { return indices.empty() ? i : indices[i]; }
+};
+
+// Column is split to blocks `[count][bytes][entities][payload]` of about chunk size, so it can be read by parts.
+// Blocks are independent, so ranges of one column can be written separately and concatenated.
+// `payload(first, last)` writes components of the selected elements [first, last)
+template<typename Payload>
+void writeBlocks(Writer&                 writer,
+                 std::span<const Entity> ents,
+                 Range                   range,
+                 std::size_t             component_size,
+                 Payload&&               payload) {
+    auto count = std::max<std::size_t>(writer.chunkSize() / (sizeof(Entity) + component_size), 1);
+    for (std::size_t first = range.first; first < range.last; first += count) {
+        auto last = std::min(first + count, range.last);
+        writer.beginBlock(last - first, (last - first) * (sizeof(Entity) + component_size));
+        if (range.indices.empty()) {
+            writer.write(ents.data() + first, (last - first) * sizeof(Entity));
+        } else {
+            for (auto i = first; i < last; ++i) {
+                writer.write(ents[range[i]]);
+            }
+        }
+        payload(first, last);
+        writer.endBlock();
+    }
+}
+
+// writes trivially copyable components
+template<typename Component>
+void writeColumn(Writer& writer, std::span<const Entity> ents, std::span<const Component> components, Range range) {
+    writeBlocks(writer, ents, range, sizeof(Component), [&](auto first, auto last) {
+        if (range.indices.empty()) {
+            writer.write(components.data() + first, (last - first) * sizeof(Component));
+            return;
+        }
+        for (auto i = first; i < last; ++i) {
+            writer.write(components[range[i]]);
+        }
+    });
+}
+
+// Savers and loaders which return and take raw buffers are adapted to the views
+template<typename Component, typename Callback>
+auto viewSaver(Callback&& func) {
+    if constexpr (std::is_invocable_v<Callback, const Component&, ::serializer::OutputView&>) {
+        return std::forward<Callback>(func);
+    } else {
+        return [func = std::forward<Callback>(func)](const Component& comp, ::serializer::OutputView& out) {
+            out.writeBytes(func(comp));
+        };
+    }
+}
+
+template<typename Component, typename Callback>
+auto viewLoader(Callback&& func) {
+    if constexpr (std::is_invocable_r_v<Component, Callback, ::serializer::InputView&>) {
+        return std::forward<Callback>(func);
+    } else {
+        return [func = std::forward<Callback>(func)](::serializer::InputView& in) -> Component {
+            auto data = in.position();
+            auto comp = func(data);
+            in.readBytes(static_cast<std::size_t>(data - in.position()));
+            return comp;
+        };
+    }
+}
+
+// writes components converted by the custom saver
+template<typename Component, typename Callback>
+void writeCustomColumn(Writer&                    writer,
+                       std::span<const Entity>    ents,
+                       std::span<const Component> components,
+                       Range                      range,
+                       const Callback&            func) {
+    // size of components is unknown, so the block is collected before writing
+    auto                     block = TMP_GET(::serializer::Output);
+    ::serializer::OutputView out(*block);
+    for (std::size_t first = range.first, last = range.first; first < range.last; first = last) {
+        block->clear();
+        while (last < range.last && block->size() < writer.chunkSize()) {
+            func(components[range[last++]], out);
+        }
+
+        writer.beginBlock(last - first, (last - first) * sizeof(Entity) + block->size());
+        for (auto i = first; i < last; ++i) {
+            writer.write(ents[range[i]]);
+        }
+        writer.write(block->data(), block->size());
+        writer.endBlock();
+    }
+}
+
+// reads `count` entities of the block and maps them to the loaded ones. Returns false if one is not in the table
+[[nodiscard]] inline bool readEntities(::serializer::Input&       data,
+                                       std::size_t                count,
+                                       std::span<const Entity>    loaded,
+                                       std::vector<Entity>&       ents) {
+    ents.resize(count);
+    std::memcpy(ents.data(), data, count * sizeof(Entity));
+    data += count * sizeof(Entity);
+
+    for (auto& e : ents) {
+        if (e >= loaded.size()) {
+            spdlog::error("Entity {} is not in the entity table", e);
+            return false;
+        }
+        e = loaded[e];
+    }
+    return true;
+}
+
+} // namespace detail::serializer
+
+
+namespace serializer
+{
+
+// State of the world at the last delta snapshot. Components stamped at its tick or later are saved,
+// the removed ones are found by the entities which had the component. It's a copy of the sorted entities of the world
+// and of every saved storage, so a delta takes O(entities) time and memory besides the changes
+struct Baseline {
+    Tick                                               tick = 0; // zero saves all components
+    std::vector<Entity>                                entities;
+    std::unordered_map<Component, std::vector<Entity>> components; // sorted entities with the component
+};
+
+} // namespace serializer
+
+
+// Snapshot is a sequence of sections `[id][type][count]` followed by blocks `[count][bytes][entities][payload]`.
+// The first section is the entity table, then one column per component. Components are stored in the storage order,
+// so trivially copyable components are saved with a copy of the whole block. Unknown sections are skipped on load.
+// Blocks are about `chunk_size` bytes, so the snapshot can be streamed with bounded memory: `save` encodes at most
+// `2 * (JobScheduler::thread_count + 1)` parts of about `chunk_size` bytes at once. Parts are sized by the inline size
+// of the components, memory owned by them, e.g. strings, makes the parts larger.
+// Sections are listed with their offsets, sizes and checksums in the table of contents at the end.
 struct Serializer final {
-    Serializer(World& world);
+    // Saves blocks of the selected elements of the dense arrays
+    using SaveFunction = std::function<void(detail::serializer::Writer&, detail::serializer::Range)>;
+    // Loads one block. Gets the map from the saved entities to the loaded ones and appends the loaded entities.
+    // The block holds at least the entities. Returns false if the block is corrupted
+    using LoadFunction = std::function<bool(
+      std::span<const serializer::Data>, std::size_t, std::span<const Entity>, std::vector<Entity>&)>;
+
+    struct Loader {
+        std::function<void(std::size_t)>          reserve; // storages are sized before the blocks are loaded
+        LoadFunction                              load;
+        std::function<void(std::vector<Entity>&)> finish; // marks the loaded components as `Updated` at once
+        std::function<bool(void)>                 serial; // destroy callbacks are run on the calling thread
+        std::function<void(bool)>                 defer;  // construct callbacks are run after all storages are loaded
+    };
+
+    struct Column {
+        SaveFunction                                    save;
+        std::function<std::span<const Entity>(void)>    entities; // in the order of the dense array
+        std::function<std::span<const Tick>(void)>      ticks;    // change ticks in the order of the dense array
+        std::function<const std::vector<Entity>&(void)> sorted;   // sorted entities, removals are found by them
+        std::function<SaveFunction(void)>               capture;  // copies the column, result saves the copy
+        std::size_t                                     element;  // inline bytes of a saved element with its entity
+    };
+
+    Serializer(World& world, JobScheduler& jobs);
 
     serializer::Output save();
-    void               load(std::span<const serializer::Data>);
+    void               save(serializer::Sink sink, std::size_t chunk_size = serializer::CHUNK_SIZE);
+
+    // The world is captured at the end of the next frame and saved on a worker thread while the simulation continues.
+    // The frame pays only for the copy of the columns. Sink is called from the worker thread.
+    // Requests wait for a frame (`exec`, `run` or `Registry::step`), a registry destroyed before it drops them:
+    // the snapshot is empty and the sink version gives false. Captured saves are finished by the destructor
+    std::future<serializer::Output> saveAsync();
+    std::future<bool>               saveAsync(serializer::Sink sink, std::size_t chunk_size = serializer::CHUNK_SIZE);
+
+    // captures the world for the requested async saves, called by the registry at the end of the frame
+    bool asyncPending() const noexcept { return m_async_pending.load(std::memory_order_relaxed); }
+    void capture();
+
+    // drops the requests which were not captured and waits for the captured saves, called by the registry
+    void finishAsync();
+
+    // Loads the entities and the components from `only`, all of them if it's empty. Returns false if the data is not
+    // a snapshot of this version or is corrupted. Sections in memory are found by the table of contents, so the
+    // skipped ones are not read at all, and checked by the checksum before load. Stream is checked by the table of
+    // contents at its end, so a corrupted stream may be loaded in part before it's found
+    bool load(std::span<const serializer::Data>, std::span<const Component> only = {});
+    bool load(serializer::Source source, std::span<const Component> only = {});
+
+    // Loads the snapshot straight from the memory mapped file. Columns of components without a registered loader
+    // are kept mapped and loaded when the loader is registered, so only the storages in use are touched.
+    // In the lazy mode all columns are kept mapped, so the load costs only the entity table.
+    // Any following load drops the columns still pending, even if it fails
+    bool load(const std::filesystem::path& path,
+              std::span<const Component> only = {},
+              serializer::LoadMode       mode = serializer::LoadMode::Eager);
+
+    // Loads the mapped column of the component, call it before the first use of the storage after a lazy load.
+    // Returns false if the column is corrupted or the component has no loader. Saves load all pending columns
+    bool loadPending(Component id);
+    bool loadPending();
+
+    // Saves entities and components which were created, changed or removed since the baseline and updates it.
+    // The first delta with an empty baseline contains the whole world and can be loaded with `load`.
+    // The tick of the world is not advanced, components changed in the tick of the delta are saved by the next one too
+    serializer::Output saveDelta(serializer::Baseline& baseline);
+    void               saveDelta(serializer::Baseline& baseline,
+                                 serializer::Sink      sink,
+                                 std::size_t           chunk_size = serializer::CHUNK_SIZE);
+
+    // applies the delta on top of the previously loaded snapshot
+    bool loadDelta(std::span<const serializer::Data>);
+
+    // codec of the sections without their own one, the entity table included
+    void setCompression(serializer::Codec codec) noexcept { m_codec = codec; }
+
+    template<typename Component>
+    void setCompression(serializer::Codec codec) {
+        m_codecs[ct::ID<Component>] = codec;
+    }
 
     template<typename Component>
     requires std::is_trivially_copyable_v<Component>
     void registerType();
 
+    // Saver writes the component to `serializer::OutputView&`, loader reads it from `serializer::InputView&`.
+    // Savers returning `serializer::Output` and loaders taking `serializer::Input&` are supported too.
+    // Parts of the columns are saved and loaded in parallel on the job threads, so the callbacks are called from
+    // several threads at once
     template<typename Component, typename Callback>
-    requires std::is_invocable_r_v<serializer::Output, Callback, const Component&>
+    requires std::is_invocable_v<Callback, const Component&, serializer::OutputView&> ||
+             std::is_invocable_r_v<serializer::Output, Callback, const Component&>
     void registerCustomSaver(Callback&& f);
 
     template<typename Component, typename Callback>
-    requires std::is_invocable_r_v<Component, Callback, serializer::Input&>
+    requires std::is_invocable_r_v<Component, Callback, serializer::InputView&> ||
+             std::is_invocable_r_v<Component, Callback, serializer::Input&>
     void registerCustomLoader(Callback&& f);
 
 private:
+    struct Pending {
+        std::span<const serializer::Data> section;
+        detail::serializer::TocEntry      entry;
+    };
+
+    struct AsyncSave {
+        serializer::Sink          sink;
+        std::size_t               chunk_size;
+        std::function<void(bool)> done; // false if the request is dropped
+    };
+
     // tags
     template<typename Component>
     requires(std::is_empty_v<Component>)
@@ -75,10 +580,71 @@ private:
     requires(!std::is_empty_v<Component>)
     void addLoadCallback();
 
+    template<typename Component>
+    void addRemoveCallback();
+
+    // registers the save function of the component, capture copies the column for the async save
+    template<typename Component>
+    void addColumn(SaveFunction save, std::function<SaveFunction(void)> capture);
+
+    // loaded components replace the existing ones
+    template<typename Component>
+    void eraseExisting(std::span<const Entity> ents);
+
+    // registers the loader of the component and loads its pending column
+    template<typename Component>
+    void addLoader(LoadFunction load);
+
+    template<typename Component>
+    void addLoadedComponents(std::vector<Entity>& ents);
+
+    bool loadSections(detail::serializer::Reader& reader,
+                      std::span<const Component>  only,
+                      bool                        keep_pending,
+                      bool                        lazy,
+                      bool                        is_delta);
+    // entities of the saved ids are created at once
+    void createEntities(std::span<const Entity> saved);
+    // loads one section of the component, components are marked as `Updated` once per section.
+    // Functions below return false if the data is truncated or corrupted
+    bool loadColumn(detail::serializer::Reader& reader, const detail::serializer::TocEntry& entry);
+    bool loadBlocks(detail::serializer::Reader& reader,
+                    detail::serializer::Size    count,
+                    serializer::Codec           codec,
+                    const LoadFunction&         load,
+                    std::vector<Entity>&        added);
+    bool skipBlocks(detail::serializer::Reader& reader, detail::serializer::Size count, serializer::Codec codec);
+
+    serializer::Codec codec(Component id) const;
+
+    // unmaps the file of the previous load together with its pending columns
+    void closeMapped();
+
+    // storages are loaded in parallel, so observers are notified after
+    void deferNotify(std::span<const Entity> ents);
+    void flushNotify();
+
 private:
-    World&                                                                          m_world;
-    std::unordered_map<Component, std::function<void(Entity, serializer::Output&)>> m_save_functions;
-    std::unordered_map<Component, std::function<void(Entity, serializer::Input&)>>  m_load_functions;
+    World&                                           m_world;
+    JobScheduler&                                    m_jobs;
+    std::unordered_map<Component, Column>            m_save_functions;
+    std::unordered_map<Component, Loader>            m_load_functions;
+    std::unordered_map<Component, LoadFunction>      m_remove_functions;
+    std::unordered_map<Component, Pending>           m_pending; // columns in m_mapped waiting for their loaders
+    std::vector<Entity>                              m_loaded;  // saved entity -> loaded entity, kept for deltas
+    std::vector<Entity>                              m_saved;   // loaded entity -> saved entity, reverse of m_loaded
+    MappedFile                                       m_mapped;
+    std::vector<AsyncSave>                           m_async_saves; // waiting for the end of the frame
+    std::atomic_bool                                 m_async_pending = false;
+    std::shared_ptr<std::atomic_size_t>              m_async_running = std::make_shared<std::atomic_size_t>(0);
+    std::vector<Entity>                              m_notify;      // loaded entities to notify about
+    std::unordered_map<Component, serializer::Codec> m_codecs;
+    serializer::Codec                                m_codec = serializer::Codec::None;
+
+    ECS_PROFILER(TracyLockable(std::mutex, m_async_mutex));
+    ECS_NO_PROFILER(std::mutex m_async_mutex);
+    ECS_PROFILER(TracyLockable(std::mutex, m_notify_mutex));
+    ECS_NO_PROFILER(std::mutex m_notify_mutex);
 };
 
 template<typename Component>
@@ -89,68 +655,296 @@ void Serializer::registerType() {
 }
 
 template<typename Component, typename Callback>
-requires std::is_invocable_r_v<serializer::Output, Callback, const Component&>
+requires std::is_invocable_v<Callback, const Component&, serializer::OutputView&> ||
+         std::is_invocable_r_v<serializer::Output, Callback, const Component&>
 void Serializer::registerCustomSaver(Callback&& f) { // NOLINT
     assert(!m_save_functions.contains(ct::ID<Component>) && "Component already has save function");
-    auto [_, was_added] = m_save_functions.try_emplace(
-      ct::ID<Component>, [&world = m_world, func = std::forward<Callback>(f)](Entity e, serializer::Output& data) {
-          if (world.has<Component>(e)) {
-              const Component& comp  = world.get<Component>(e);
-              auto&&           bytes = func(comp);
-
-              auto&& id = serializer::serialize(ct::ID<Component>);
-              std::ranges::copy(id, std::back_inserter(data));
-              std::ranges::copy(bytes, std::back_inserter(data));
-          }
-      });
-    assert(was_added);
+
+    auto func = detail::serializer::viewSaver<Component>(std::forward<Callback>(f));
+    auto save = [&world = m_world, func](detail::serializer::Writer& writer, detail::serializer::Range range) {
+        const auto& storage = world.storage<Component>();
+        detail::serializer::writeCustomColumn<Component>(writer, storage.dense(), storage.components(), range, func);
+    };
+
+    auto capture = [&world = m_world, func]() -> SaveFunction {
+        const auto& storage = world.storage<Component>();
+        std::vector<Entity> ents(storage.dense().begin(), storage.dense().end());
+
+        if constexpr (std::is_copy_constructible_v<Component>) {
+            std::vector<Component> components(storage.components().begin(), storage.components().end());
+            return [ents = std::move(ents), components = std::move(components), func](
+                     detail::serializer::Writer& writer, detail::serializer::Range range) {
+                detail::serializer::writeCustomColumn<Component>(writer, ents, components, range, func);
+            };
+        } else {
+            // component can't be copied, so it's converted right away. Blocks are made by the writer of the save,
+            // so they get its codec and chunk size
+            serializer::Output       bytes;
+            serializer::OutputView   out(bytes);
+            std::vector<std::size_t> ends;
+            ends.reserve(ents.size());
+            for (const auto& component : storage.components()) {
+                func(component, out);
+                ends.emplace_back(bytes.size());
+            }
+
+            // moved vector keeps its buffer, so the views stay valid
+            std::vector<std::span<const serializer::Data>> converted;
+            converted.reserve(ents.size());
+            for (std::size_t i = 0, begin = 0; i < ends.size(); begin = ends[i++]) {
+                converted.emplace_back(std::span(bytes).subspan(begin, ends[i] - begin));
+            }
+            return [ents = std::move(ents), bytes = std::move(bytes), converted = std::move(converted)](
+                     detail::serializer::Writer& writer, detail::serializer::Range range) {
+                detail::serializer::writeCustomColumn<std::span<const serializer::Data>>(
+                  writer, ents, converted, range, [](auto component, serializer::OutputView& out) {
+                      out.writeBytes(component);
+                  });
+            };
+        }
+    };
+
+    addColumn<Component>(std::move(save), std::move(capture));
 }
 
 template<typename Component, typename Callback>
-requires std::is_invocable_r_v<Component, Callback, serializer::Input&>
+requires std::is_invocable_r_v<Component, Callback, serializer::InputView&> ||
+         std::is_invocable_r_v<Component, Callback, serializer::Input&>
 void Serializer::registerCustomLoader(Callback&& f) { // NOLINT
     assert(!m_load_functions.contains(ct::ID<Component>) && "Component already has load function");
-    auto [_, was_added] = m_load_functions.try_emplace(
-      ct::ID<Component>, [&world = m_world, func = std::forward<Callback>(f)](Entity e, serializer::Input& data) {
-          Component&& comp = func(data);
-          world.emplace(e, std::move(comp));
-          world.markUpdated<Component>(e);
-      });
-    assert(was_added);
+    addLoader<Component>([this, func = detail::serializer::viewLoader<Component>(std::forward<Callback>(f))](
+                           std::span<const serializer::Data> block,
+                           std::size_t                       count,
+                           std::span<const Entity>           loaded,
+                           std::vector<Entity>&              added) {
+        serializer::Input data = block.data();
+        auto              ents = TMP_GET(std::vector<Entity>);
+        if (!detail::serializer::readEntities(data, count, loaded, *ents)) {
+            return false;
+        }
+        eraseExisting<Component>(*ents);
+
+        serializer::InputView in(block.subspan(count * sizeof(Entity)));
+        auto&                 storage = m_world.storage<Component>();
+        for (auto e : *ents) {
+            auto&& comp = func(in);
+            if (!in.good()) {
+                spdlog::error("Loader of {} read past the end of the block", ct::NAME<Component>);
+                return false;
+            }
+            if (e != detail::serializer::SKIPPED) {
+                storage.emplace(e, std::move(comp));
+                added.emplace_back(e);
+            }
+        }
+        return true;
+    });
 }
 
 template<typename Component>
 requires(std::is_empty_v<Component>)
 void Serializer::addSaveCallback() {
-    auto [_, was_added] =
-      m_save_functions.try_emplace(ct::ID<Component>, [&world = m_world](Entity e, serializer::Output& data) {
-          if (world.has<Component>(e)) {
-              const auto& id = serializer::serialize(ct::ID<Component>);
-              std::ranges::copy(id, std::back_inserter(data));
-          }
-      });
-    assert(was_added);
+    auto save = [&world = m_world](detail::serializer::Writer& writer, detail::serializer::Range range) {
+        detail::serializer::writeBlocks(writer, world.storage<Component>().dense(), range, 0, [](auto, auto) {});
+    };
+
+    auto capture = [&world = m_world]() -> SaveFunction {
+        auto dense = world.storage<Component>().dense();
+        return [ents = std::vector<Entity>(dense.begin(), dense.end())](detail::serializer::Writer&    writer,
+                                                                          detail::serializer::Range   range) {
+            detail::serializer::writeBlocks(writer, ents, range, 0, [](auto, auto) {});
+        };
+    };
+
+    addColumn<Component>(std::move(save), std::move(capture));
 }
 
 template<typename Component>
 requires(std::is_empty_v<Component>)
 void Serializer::addLoadCallback() {
-    auto [_, was_added] =
-      m_load_functions.try_emplace(ct::ID<Component>, [&world = m_world](Entity e, serializer::Input& /*fs*/) {
-          world.emplace<Component>(e);
-          world.markUpdated<Component>(e);
-      });
-    assert(was_added);
+    addLoader<Component>([this](std::span<const serializer::Data> block,
+                                std::size_t                       count,
+                                std::span<const Entity>           loaded,
+                                std::vector<Entity>&              added) {
+        serializer::Input data = block.data();
+        auto              ents = TMP_GET(std::vector<Entity>);
+        if (!detail::serializer::readEntities(data, count, loaded, *ents)) {
+            return false;
+        }
+        std::erase(*ents, detail::serializer::SKIPPED);
+
+        m_world.storage<Component>().emplace(*ents);
+        added.insert(added.end(), ents->begin(), ents->end());
+        return true;
+    });
 }
 
 template<typename Component>
 requires(!std::is_empty_v<Component>)
 void Serializer::addSaveCallback() {
-    registerCustomSaver<Component>(serializer::serialize<Component>);
+    auto save = [&world = m_world](detail::serializer::Writer& writer, detail::serializer::Range range) {
+        const auto& storage = world.storage<Component>();
+        detail::serializer::writeColumn(writer, storage.dense(), storage.components(), range);
+    };
+
+    // bulk copy of both arrays
+    auto capture = [&world = m_world]() -> SaveFunction {
+        const auto& storage    = world.storage<Component>();
+        auto        dense      = storage.dense();
+        auto        components = storage.components();
+        return [ents       = std::vector<Entity>(dense.begin(), dense.end()),
+                components = std::vector<Component>(components.begin(), components.end())](
+                 detail::serializer::Writer& writer, detail::serializer::Range range) {
+            detail::serializer::writeColumn<Component>(writer, ents, components, range);
+        };
+    };
+
+    addColumn<Component>(std::move(save), std::move(capture));
 }
 
 template<typename Component>
 requires(!std::is_empty_v<Component>)
 void Serializer::addLoadCallback() {
-    registerCustomLoader<Component>(serializer::deserialize<Component>);
+    addLoader<Component>([this](std::span<const serializer::Data> block,
+                                std::size_t                       count,
+                                std::span<const Entity>           loaded,
+                                std::vector<Entity>&              added) {
+        if (block.size() < count * (sizeof(Entity) + sizeof(Component))) {
+            spdlog::error("Block of {} is shorter than its {} components", ct::NAME<Component>, count);
+            return false;
+        }
+
+        serializer::Input data = block.data();
+        auto              ents = TMP_GET(std::vector<Entity>);
+        if (!detail::serializer::readEntities(data, count, loaded, *ents)) {
+            return false;
+        }
+        eraseExisting<Component>(*ents);
+
+        // data is not aligned, so components are copied by bytes
+        auto component = [data](std::size_t i) {
+            serializer::Input ptr = data + i * sizeof(Component);
+            return serializer::deserialize<Component>(ptr);
+        };
+
+        auto& storage = m_world.storage<Component>();
+        if (std::ranges::find(*ents, detail::serializer::SKIPPED) == ents->end()) [[likely]] {
+            if constexpr (std::is_default_constructible_v<Component>) {
+                storage.emplace(*ents, static_cast<const void*>(data)); // one copy of the whole block
+            } else {
+                auto components = std::views::iota(std::size_t{0}, ents->size()) | std::views::transform(component);
+                storage.emplace(*ents, components);
+            }
+            added.insert(added.end(), ents->begin(), ents->end());
+        } else {
+            for (std::size_t i = 0; i < ents->size(); ++i) {
+                if ((*ents)[i] != detail::serializer::SKIPPED) {
+                    storage.emplace((*ents)[i], component(i));
+                    added.emplace_back((*ents)[i]);
+                }
+            }
+        }
+        return true;
+    });
+}
+
+template<typename Component>
+void Serializer::addRemoveCallback() {
+    m_remove_functions.try_emplace(
+      ct::ID<Component>,
+      [this](std::span<const serializer::Data> block,
+             std::size_t                       count,
+             std::span<const Entity>           loaded,
+             std::vector<Entity>& /*unused*/) {
+          serializer::Input data = block.data();
+          auto              ents = TMP_GET(std::vector<Entity>);
+          if (!detail::serializer::readEntities(data, count, loaded, *ents)) {
+              return false;
+          }
+          std::ranges::sort(*ents);
+          std::erase(*ents, detail::serializer::SKIPPED);
+
+          m_world.storage<Component>().erase(*ents);
+          if (m_world.hasStorage<Updated<Component>>()) {
+              m_world.storage<Updated<Component>>().erase(*ents);
+          }
+          deferNotify(*ents);
+          return true;
+      });
+}
+
+template<typename Component>
+void Serializer::addColumn(SaveFunction save, std::function<SaveFunction(void)> capture) {
+    [[maybe_unused]] auto [_, was_added] = m_save_functions.try_emplace(
+      ct::ID<Component>,
+      Column{std::move(save),
+             [&world = m_world] { return world.storage<Component>().dense(); },
+             [&world = m_world] { return world.storage<Component>().ticks(); },
+             [&world = m_world]() -> const std::vector<Entity>& { return world.storage<Component>().entities(); },
+             std::move(capture),
+             sizeof(Entity) + (std::is_empty_v<Component> ? 0 : sizeof(Component))});
+    assert(was_added);
+}
+
+template<typename Component>
+void Serializer::eraseExisting(std::span<const Entity> ents) {
+    auto& storage  = m_world.storage<Component>();
+    auto  existing = TMP_GET(std::vector<Entity>);
+    for (auto e : ents) {
+        if (e != detail::serializer::SKIPPED && storage.has(e)) {
+            existing->emplace_back(e);
+        }
+    }
+
+    if (!existing->empty()) {
+        std::ranges::sort(*existing);
+        storage.erase(*existing);
+    }
+}
+
+template<typename Component>
+void Serializer::addLoader(LoadFunction load) {
+    // Loaded components are tagged only if the tag storage exists, i.e. `Updated<Component>` is tracked by a filter,
+    // `markUpdated` or `trackUpdates`. Loads never create it, so the parallel loads don't add storages
+    auto reserve = [this](std::size_t count) {
+        auto& storage = m_world.storage<Component>();
+        storage.reserve(storage.size() + count);
+        if (m_world.hasStorage<Updated<Component>>()) {
+            auto& updated = m_world.storage<Updated<Component>>();
+            updated.reserve(updated.size() + count);
+        }
+    };
+
+    // user callbacks may read other storages, which are written by the parallel loads
+    auto serial = [&world = m_world] {
+        return world.storage<Component>().hasDestroyCallbacks() ||
+               (world.hasStorage<Updated<Component>>() && world.storage<Updated<Component>>().hasDestroyCallbacks());
+    };
+    auto defer = [&world = m_world](bool on) {
+        world.storage<Component>().deferCallbacks(on);
+        if (world.hasStorage<Updated<Component>>()) {
+            world.storage<Updated<Component>>().deferCallbacks(on);
+        }
+    };
+
+    [[maybe_unused]] auto [_, was_added] = m_load_functions.try_emplace(
+      ct::ID<Component>,
+      Loader{std::move(reserve),
+             std::move(load),
+             [this](std::vector<Entity>& added) { addLoadedComponents<Component>(added); },
+             std::move(serial),
+             std::move(defer)});
+    assert(was_added);
+    addRemoveCallback<Component>();
+    loadPending(ct::ID<Component>);
+}
+
+template<typename Component>
+void Serializer::addLoadedComponents(std::vector<Entity>& ents) {
+    // sorted entities are merged into the tag storage at once
+    std::ranges::sort(ents);
+    if (m_world.hasStorage<Updated<Component>>()) {
+        m_world.storage<Updated<Component>>().emplace(ents);
+    }
+    deferNotify(ents);
 }
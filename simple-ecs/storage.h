@@ -1,14 +1,92 @@
 #pragma once
 
+#include "simple-ecs/components.h"
 #include "simple-ecs/entity.h"
 #include "tools/profiler.h"
 #include "tools/sparse_set.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
 #include <shared_mutex>
 #include <span>
 
 
+// bytes taken by the alive elements and allocated
+struct MemoryBlock {
+    std::size_t used     = 0;
+    std::size_t capacity = 0;
+
+    MemoryBlock& operator+=(const MemoryBlock& rhs) noexcept {
+        used += rhs.used;
+        capacity += rhs.capacity;
+        return *this;
+    }
+};
+
+struct MemoryStats {
+    std::size_t size = 0;   // alive elements
+    MemoryBlock dense;
+    MemoryBlock sparse;     // slots up to the highest stored entity
+    MemoryBlock entities;   // sorted entity index
+    MemoryBlock ticks;      // change ticks of the components
+    MemoryBlock components; // inline size, memory owned by the components is not counted
+
+    std::size_t used() const noexcept {
+        return dense.used + sparse.used + entities.used + ticks.used + components.used;
+    }
+    std::size_t capacity() const noexcept {
+        return dense.capacity + sparse.capacity + entities.capacity + ticks.capacity + components.capacity;
+    }
+    // share of the allocated bytes which are not used by the alive elements
+    double fragmentation() const noexcept { return capacity() ? 1. - static_cast<double>(used()) / capacity() : 0.; }
+
+    MemoryStats& operator+=(const MemoryStats& rhs) noexcept {
+        size += rhs.size;
+        dense += rhs.dense;
+        sparse += rhs.sparse;
+        entities += rhs.entities;
+        ticks += rhs.ticks;
+        components += rhs.components;
+        return *this;
+    }
+};
+
+
+// World tick of the last change of a component. The world advances it at the beginning of every frame,
+// at 60 frames per second it wraps after two years
+using Tick = std::uint32_t;
+
+
+// Storages only grow while entities are added. A storage which uses less than `ratio` of the allocated elements for
+// at least `frames` frames is shrunk to twice its size, the sparse array is cut after the highest alive entity.
+// The registry checks one storage per frame, so the copies are spread over the frames
+struct CompactionPolicy {
+    double        ratio     = 0.25; // zero disables the compaction
+    std::uint64_t frames    = 600;
+    std::size_t   min_bytes = 64 * 1024; // smaller storages are not worth a copy
+};
+
+
+namespace detail::storage
+{
+
+// moves the elements to a new buffer with the room for `capacity` elements
+template<typename T>
+void shrink(std::vector<T>& vector, std::size_t capacity) {
+    std::vector<T> result;
+    result.reserve(std::max(capacity, vector.size()));
+    std::ranges::move(vector, std::back_inserter(result));
+    vector.swap(result);
+}
+
+} // namespace detail::storage
+
+
 struct StorageBase : SparseSet, NoCopyNoMove {
     StorageBase()           = default;
     ~StorageBase() override = default;
@@ -21,19 +99,41 @@ struct StorageBase : SparseSet, NoCopyNoMove {
     decltype(auto) size() const noexcept { return entities().size(); }
     decltype(auto) empty() const noexcept { return entities().empty(); }
 
+    // emplaced and changed components are stamped with the current tick of the clock
+    void setClock(const Tick* clock) noexcept { m_clock = clock; }
+    Tick tick() const noexcept { return *m_clock; }
+
     virtual void remove(Entity e)                     = 0;
     virtual void remove(std::span<const Entity> ents) = 0;
 
     ECS_DEBUG_ONLY(IDType id() const noexcept { return m_id; })
     ECS_DEBUG_ONLY(std::string name() const noexcept { return m_string_name; })
 
-    virtual bool optimize() = 0;
+    virtual bool        optimize()                                                     = 0;
+    virtual MemoryStats memoryStats() const                                            = 0;
+    virtual bool        compact(const CompactionPolicy& policy, std::uint64_t frame) = 0; // true if shrunk
+    virtual void        markChanged()                                                  = 0; // all components
+
+    // World snapshots copy the state without callbacks, so the buffers of the target are reused
+    virtual std::unique_ptr<StorageBase> makeEmpty() const                      = 0;
+    virtual void                         copyTo(StorageBase& target) const       = 0;
+    virtual void                         copyValuesTo(StorageBase& target) const = 0; // same entities in the same order
+    virtual bool                         copyable() const noexcept               = 0; // move-only can't be copied
+
+    // World snapshots keep the copies of unchanged storages. The version grows when components are emplaced, erased
+    // or moved, changed values are found by their ticks, so the accessors don't write anything shared
+    std::uint64_t version() const noexcept { return m_version; }
+    virtual bool  changedSince(Tick since) const noexcept = 0; // any component stamped at `since` or later
 
 protected:
     ECS_PROFILER(mutable TracySharedLockable(std::shared_mutex, m_mutex));
     ECS_NO_PROFILER(mutable std::shared_mutex m_mutex);
 
     std::vector<Entity> m_entities;
+    std::uint64_t       m_version = 0;
+
+    static constexpr Tick NO_CLOCK = 0;
+    const Tick*           m_clock  = &NO_CLOCK; // snapshot copies are never changed, so they don't have a clock
 
     ECS_DEBUG_ONLY(std::string m_string_name);
     ECS_DEBUG_ONLY(IDType m_id = 0);
@@ -50,6 +150,9 @@ struct Storage final : StorageBase {
                                         std::function<void(Entity)>,
                                         std::function<void(Entity, Component&)>>;
 
+    // `Updated` tags are only emplaced and erased, nothing reads their change ticks
+    static constexpr bool HAS_TICKS = !IS_UPDATED<Component>;
+
     Storage() {                                              //-V832
         ECS_DEBUG_ONLY(m_string_name = ct::NAME<Component>); // NOLINT
         ECS_DEBUG_ONLY(m_id = ct::ID<Component>);            // NOLINT
@@ -69,8 +172,83 @@ struct Storage final : StorageBase {
     void remove(Entity e) override { erase(e); }
     void remove(std::span<const Entity> ents) override { erase(ents); }
 
+    std::unique_ptr<StorageBase> makeEmpty() const override { return std::make_unique<Storage>(); }
+
+    void copyTo(StorageBase& base) const override {
+        ECS_PROFILER(ZoneScoped);
+
+        auto& target = static_cast<Storage&>(base);
+        ++target.m_version;
+        copyValuesTo(target);
+
+        target.m_dense        = m_dense;
+        target.m_sparse       = m_sparse;
+        target.m_is_optimized = m_is_optimized;
+
+        std::shared_lock source_lock(m_mutex);
+        std::unique_lock target_lock(target.m_mutex);
+        target.m_entities = m_entities;
+    }
+
+    // trivially copyable components are copied in bulk, the others are copy constructed. The entity lists are kept,
+    // so the version of the target doesn't change
+    void copyValuesTo(StorageBase& base) const override {
+        ECS_PROFILER(ZoneScoped);
+
+        auto& target = static_cast<Storage&>(base);
+        if constexpr (std::is_copy_constructible_v<Component> && std::is_copy_assignable_v<Component>) {
+            target.m_components = m_components;
+        } else if constexpr (std::is_copy_constructible_v<Component>) {
+            // assignment and insert of the vector assign the elements, so they are constructed anew
+            target.m_components.clear();
+            target.m_components.reserve(m_components.size());
+            for (const auto& component : m_components) {
+                target.m_components.emplace_back(component);
+            }
+        } else {
+            ECS_ASSERT(m_components.empty(), "Component is not copyable, so it can't be saved in a world snapshot");
+            target.m_components.clear();
+        }
+        target.m_ticks = m_ticks;
+    }
+
+    bool copyable() const noexcept override { return std::is_copy_constructible_v<Component> || m_components.empty(); }
+
+    MemoryStats memoryStats() const override {
+        MemoryStats stats;
+        stats.size   = m_dense.size();
+        stats.dense  = {m_dense.size() * sizeof(Entity), m_dense.capacity() * sizeof(Entity)};
+        stats.sparse = {m_sparse.size() * sizeof(Entity), m_sparse.capacity() * sizeof(Entity)};
+        stats.ticks  = {m_ticks.size() * sizeof(Tick), m_ticks.capacity() * sizeof(Tick)};
+        if constexpr (!std::is_empty_v<Component>) {
+            stats.components = {m_components.size() * sizeof(Component), m_components.capacity() * sizeof(Component)};
+        }
+
+        std::shared_lock _(m_mutex);
+        stats.entities = {m_entities.size() * sizeof(Entity), m_entities.capacity() * sizeof(Entity)};
+        return stats;
+    }
+
     void addEmplaceCallback(Callback&& func) { m_on_construct_callbacks.emplace_back(std::forward<Callback>(func)); }
     void addDestroyCallback(Callback&& func) { m_on_destroy_callbacks.emplace_back(std::forward<Callback>(func)); }
+    bool hasDestroyCallbacks() const noexcept { return !m_on_destroy_callbacks.empty(); }
+
+    // Construct callbacks of the components emplaced while deferred are run when deferring is turned off.
+    // Storages are loaded in parallel, so the callbacks are run on the calling thread after all of them
+    void deferCallbacks(bool defer) {
+        m_defer_callbacks = defer;
+        if (defer || m_deferred.empty()) {
+            return;
+        }
+
+        auto deferred = TMP_GET(std::vector<Entity>);
+        deferred->swap(m_deferred);
+        std::ranges::sort(*deferred);
+        auto [first, last] = std::ranges::unique(*deferred);
+        deferred->erase(first, last);
+        std::erase_if(*deferred, [this](Entity e) { return !has(e); });
+        constructed(*deferred);
+    }
 
 
     template<typename... Args>
@@ -79,6 +257,7 @@ struct Storage final : StorageBase {
         if (SparseSet::emplace(e)) {
             ECS_PROFILER(ZoneScoped);
 
+            ++m_version;
             auto lower = std::ranges::lower_bound(m_entities, e);
             m_is_optimized &= lower == m_entities.end();
 
@@ -90,14 +269,11 @@ struct Storage final : StorageBase {
             if constexpr (!std::is_empty_v<Component>) {
                 m_components.emplace_back(std::forward<Args>(args)...);
             }
-
-            for (const auto& function : m_on_construct_callbacks) { // do something after construct
-                if constexpr (std::is_empty_v<Component>) {
-                    std::invoke(function, e);
-                } else {
-                    std::invoke(function, e, m_components[m_sparse[e]]);
-                }
+            if constexpr (HAS_TICKS) {
+                m_ticks.emplace_back(tick());
             }
+
+            constructed({&e, 1}); // do something after construct
         }
     }
 
@@ -110,6 +286,216 @@ struct Storage final : StorageBase {
     }
 
 
+    // bulk version of emplace. Component i is constructed for entity i. Existing components are not replaced
+    template<std::ranges::sized_range Range>
+    requires(!std::is_empty_v<Component> &&
+             std::is_constructible_v<Component, std::ranges::range_reference_t<Range>>)
+    void emplace(std::span<const Entity> ents, Range&& components) {
+        ECS_PROFILER(ZoneScoped);
+
+        assert(ents.size() == std::ranges::size(components));
+
+        ++m_version;
+        reserve(m_dense.size() + ents.size());
+
+        auto added = TMP_GET(std::vector<Entity>);
+        added->reserve(ents.size());
+
+        auto component = std::ranges::begin(components);
+        for (const Entity& e : ents) {
+            if (SparseSet::emplace(e)) {
+                m_components.emplace_back(*component);
+                added->emplace_back(e);
+            }
+            ++component;
+        }
+        m_ticks.resize(m_dense.size(), tick());
+
+        if (added->empty()) {
+            return;
+        }
+
+        // components are added in the given order, so the storage stays optimized only for sorted input
+        m_is_optimized &= std::ranges::is_sorted(*added) && (m_entities.empty() || m_entities.back() < added->front());
+
+        std::ranges::sort(*added);
+        {
+            std::unique_lock _(m_mutex);
+            auto             middle = m_entities.insert(m_entities.end(), added->begin(), added->end());
+            if (middle != m_entities.begin() && *std::prev(middle) > *middle) {
+                std::inplace_merge(m_entities.begin(), middle, m_entities.end());
+            }
+        }
+
+        constructed(*added);
+    }
+
+    // bulk version of emplace for trivially copyable components stored back to back, e.g. in a snapshot.
+    // Component i is at `data + i * sizeof(Component)`, all components are copied at once when no entity has it yet
+    void emplace(std::span<const Entity> ents, const void* data)
+    requires(!std::is_empty_v<Component> && std::is_trivially_copyable_v<Component> &&
+             std::is_default_constructible_v<Component>)
+    {
+        ECS_PROFILER(ZoneScoped);
+
+        ++m_version;
+        reserve(m_dense.size() + ents.size());
+
+        const auto first = m_dense.size();
+        auto       added = TMP_GET(std::vector<Entity>);
+        added->reserve(ents.size());
+        for (const Entity& e : ents) {
+            if (SparseSet::emplace(e)) {
+                added->emplace_back(e);
+            }
+        }
+        m_components.resize(m_dense.size());
+        m_ticks.resize(m_dense.size(), tick());
+
+        const auto* bytes = static_cast<const std::byte*>(data);
+        if (added->size() == ents.size()) [[likely]] {
+            std::memcpy(m_components.data() + first, bytes, ents.size() * sizeof(Component));
+        } else {
+            // new entities follow `ents` in order, the others keep their components
+            for (std::size_t i = 0, k = first; i < ents.size() && k < m_dense.size(); ++i) {
+                if (m_dense[k] == ents[i]) {
+                    std::memcpy(&m_components[k++], bytes + i * sizeof(Component), sizeof(Component));
+                }
+            }
+        }
+
+        if (added->empty()) {
+            return;
+        }
+
+        m_is_optimized &= std::ranges::is_sorted(*added) && (m_entities.empty() || m_entities.back() < added->front());
+
+        std::ranges::sort(*added);
+        {
+            std::unique_lock _(m_mutex);
+            auto             middle = m_entities.insert(m_entities.end(), added->begin(), added->end());
+            if (middle != m_entities.begin() && *std::prev(middle) > *middle) {
+                std::inplace_merge(m_entities.begin(), middle, m_entities.end());
+            }
+        }
+
+        constructed(*added);
+    }
+
+    // bulk version of emplace for tags. The entity list is merged once instead of an insert per entity
+    void emplace(std::span<const Entity> ents)
+    requires std::is_empty_v<Component>
+    {
+        ECS_PROFILER(ZoneScoped);
+
+        ++m_version;
+        reserve(m_dense.size() + ents.size());
+
+        auto added = TMP_GET(std::vector<Entity>);
+        added->reserve(ents.size());
+        for (const Entity& e : ents) {
+            if (SparseSet::emplace(e)) {
+                added->emplace_back(e);
+            }
+        }
+        if constexpr (HAS_TICKS) {
+            m_ticks.resize(m_dense.size(), tick());
+        }
+
+        if (added->empty()) {
+            return;
+        }
+
+        m_is_optimized &= std::ranges::is_sorted(*added) && (m_entities.empty() || m_entities.back() < added->front());
+
+        std::ranges::sort(*added);
+        {
+            std::unique_lock _(m_mutex);
+            auto             middle = m_entities.insert(m_entities.end(), added->begin(), added->end());
+            if (middle != m_entities.begin() && *std::prev(middle) > *middle) {
+                std::inplace_merge(m_entities.begin(), middle, m_entities.end());
+            }
+        }
+
+        constructed(*added);
+    }
+
+    void reserve(std::size_t size) {
+        m_dense.reserve(size);
+        if constexpr (HAS_TICKS) {
+            m_ticks.reserve(size);
+        }
+        if constexpr (!std::is_empty_v<Component>) {
+            m_components.reserve(size);
+        }
+
+        std::unique_lock _(m_mutex);
+        m_entities.reserve(size);
+    }
+
+    // components in the order of `dense()`
+    [[nodiscard]] std::span<const Component> components() const noexcept
+    requires(!std::is_empty_v<Component>)
+    {
+        return m_components;
+    }
+
+    // change ticks in the order of `dense()`, empty for `Updated` tags
+    [[nodiscard]] std::span<const Tick> ticks() const noexcept { return m_ticks; }
+
+    // tick of the last emplace or change of the component
+    [[nodiscard]] ECS_FORCEINLINE Tick changed(Entity e) const noexcept
+    requires HAS_TICKS
+    {
+        assert(has(e) && "Cannot get a tick of a component which an entity does not have");
+        return m_ticks[m_sparse[e]];
+    }
+
+    [[nodiscard]] ECS_FORCEINLINE bool changedSince(Entity e, Tick since) const noexcept
+    requires HAS_TICKS
+    {
+        return has(e) && m_ticks[m_sparse[e]] >= since;
+    }
+
+    // blocks are reduced without branches, so the scan is vectorized and stops at the first changed block
+    bool changedSince(Tick since) const noexcept override {
+        constexpr std::size_t BLOCK = 1024;
+        for (std::size_t first = 0; first < m_ticks.size(); first += BLOCK) {
+            const auto last    = std::min(first + BLOCK, m_ticks.size());
+            Tick       changed = 0;
+            for (std::size_t i = first; i < last; ++i) {
+                changed |= static_cast<Tick>(m_ticks[i] >= since);
+            }
+            if (changed) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // one store, `Changed<Component>` filters see the component on their next refresh
+    ECS_FORCEINLINE void markChanged(Entity e) noexcept
+    requires HAS_TICKS
+    {
+        assert(has(e) && "Cannot mark a component which an entity does not have");
+        m_ticks[m_sparse[e]] = tick();
+    }
+
+    ECS_FORCEINLINE void markChanged(std::span<const Entity> ents) noexcept
+    requires HAS_TICKS
+    {
+        for (const Entity& e : ents) {
+            markChanged(e);
+        }
+    }
+
+    void markChanged() override {
+        if constexpr (HAS_TICKS) {
+            std::ranges::fill(m_ticks, tick());
+        }
+    }
+
+
     ECS_FORCEINLINE void erase(Entity e) {
         if (!has(e)) {
             return;
@@ -117,6 +503,7 @@ struct Storage final : StorageBase {
 
         ECS_PROFILER(ZoneScoped);
 
+        ++m_version;
         eraseOne(e);
         auto lower = std::ranges::lower_bound(m_entities, e);
 
@@ -131,6 +518,7 @@ struct Storage final : StorageBase {
 
         ECS_PROFILER(ZoneScoped);
 
+        ++m_version;
         for (const Entity& e : ents) {
             eraseOne(e);
         }
@@ -144,7 +532,8 @@ struct Storage final : StorageBase {
     }
 
 
-    [[nodiscard]] ECS_FORCEINLINE Component& get(Entity e) noexcept
+    // read only, the change tick is kept
+    [[nodiscard]] ECS_FORCEINLINE const Component& get(Entity e) const noexcept
     requires(!std::is_empty_v<Component>)
     {
         ECS_PROFILER(ZoneScoped);
@@ -153,16 +542,41 @@ struct Storage final : StorageBase {
         return m_components[m_sparse[e]];
     }
 
+    // the component may be written through the reference, so non-const access counts as a change like `getChanged`
+    [[nodiscard]] ECS_FORCEINLINE Component& get(Entity e) noexcept
+    requires(!std::is_empty_v<Component>)
+    {
+        return getChanged(e);
+    }
+
+    // get for writing, the component is marked as changed with the same lookup
+    [[nodiscard]] ECS_FORCEINLINE Component& getChanged(Entity e) noexcept
+    requires(!std::is_empty_v<Component>)
+    {
+        ECS_PROFILER(ZoneScoped);
+
+        assert(has(e) && "Cannot get a component which an entity does not have");
+        auto index     = m_sparse[e];
+        m_ticks[index] = tick();
+        return m_components[index];
+    }
+
+
+    [[nodiscard]] ECS_FORCEINLINE const Component* tryGet(Entity e) const noexcept
+    requires(!std::is_empty_v<Component>)
+    {
+        ECS_PROFILER(ZoneScoped);
 
+        return has(e) ? &m_components[m_sparse[e]] : nullptr;
+    }
+
+    // marks the component as changed if the entity has it
     [[nodiscard]] ECS_FORCEINLINE Component* tryGet(Entity e) noexcept
     requires(!std::is_empty_v<Component>)
     {
         ECS_PROFILER(ZoneScoped);
 
-        if (has(e)) {
-            return &m_components[m_sparse[e]];
-        }
-        return nullptr;
+        return has(e) ? &getChanged(e) : nullptr;
     }
 
     bool optimize() override {
@@ -175,12 +589,14 @@ struct Storage final : StorageBase {
 
             ECS_PROFILER(ZoneScoped);
 
+            ++m_version;
             m_is_optimized = true;
             // make one sort pass to avoid blocks
             for (auto it = std::next(m_dense.begin()); it < m_dense.end(); ++it) {
                 if (*std::prev(it) > *it) {
                     auto prev = std::prev(it);
                     std::swap(m_components[m_sparse[*prev]], m_components[m_sparse[*it]]);
+                    std::swap(m_ticks[m_sparse[*prev]], m_ticks[m_sparse[*it]]);
                     std::swap(m_sparse[*prev], m_sparse[*it]);
                     std::iter_swap(prev, it);
                     m_is_optimized = false;
@@ -191,6 +607,59 @@ struct Storage final : StorageBase {
         }
     }
 
+    bool compact(const CompactionPolicy& policy, std::uint64_t frame) override {
+        const auto alive = m_dense.size();
+        const auto slots = m_entities.empty() ? 0 : static_cast<std::size_t>(m_entities.back()) + 1;
+
+        auto unused = [&policy](std::size_t size, std::size_t capacity) {
+            return static_cast<double>(size) < static_cast<double>(capacity) * policy.ratio;
+        };
+
+        std::size_t capacity = (m_dense.capacity() + m_sparse.capacity() + m_entities.capacity()) * sizeof(Entity);
+        bool        shrink   = unused(alive, m_dense.capacity()) || unused(slots, m_sparse.capacity());
+        shrink |= unused(alive, m_entities.capacity()) || unused(alive, m_ticks.capacity());
+        capacity += m_ticks.capacity() * sizeof(Tick);
+        if constexpr (!std::is_empty_v<Component>) {
+            capacity += m_components.capacity() * sizeof(Component);
+            shrink |= unused(alive, m_components.capacity());
+        }
+
+        if (policy.ratio <= 0. || capacity < policy.min_bytes || !shrink) {
+            m_unused_since.reset();
+            return false;
+        }
+        if (!m_unused_since) {
+            m_unused_since = frame;
+        }
+        if (frame - *m_unused_since < policy.frames) {
+            return false;
+        }
+
+        ECS_PROFILER(ZoneScoped);
+        ECS_TRACE("Storage::compact");
+
+        m_unused_since.reset();
+
+        // the slots after the highest alive entity are never read
+        m_sparse.resize(slots);
+        detail::storage::shrink(m_sparse, slots * 2);
+        detail::storage::shrink(m_dense, alive * 2);
+        if constexpr (HAS_TICKS) {
+            detail::storage::shrink(m_ticks, alive * 2);
+        }
+        if constexpr (!std::is_empty_v<Component>) {
+            detail::storage::shrink(m_components, alive * 2);
+        }
+
+        std::vector<Entity> entities;
+        entities.reserve(alive * 2);
+        entities.assign(m_entities.begin(), m_entities.end());
+
+        std::unique_lock _(m_mutex);
+        m_entities.swap(entities);
+        return true;
+    }
+
 private:
     ECS_FORCEINLINE void eraseOne(Entity e) {
         if (!has(e)) {
@@ -211,13 +680,41 @@ private:
             std::swap(m_components[m_sparse[e]], m_components.back());
             m_components.pop_back();
         }
+        if constexpr (HAS_TICKS) {
+            std::swap(m_ticks[m_sparse[e]], m_ticks.back());
+            m_ticks.pop_back();
+        }
 
         SparseSet::erase(e);
     }
 
+    ECS_FORCEINLINE void constructed(std::span<const Entity> ents) {
+        if (m_on_construct_callbacks.empty()) {
+            return;
+        }
+        if (m_defer_callbacks) {
+            m_deferred.insert(m_deferred.end(), ents.begin(), ents.end());
+            return;
+        }
+
+        for (const auto& function : m_on_construct_callbacks) {
+            for (auto e : ents) {
+                if constexpr (std::is_empty_v<Component>) {
+                    std::invoke(function, e);
+                } else {
+                    std::invoke(function, e, m_components[m_sparse[e]]);
+                }
+            }
+        }
+    }
+
 private:
-    std::vector<Component> m_components;
-    std::vector<Callback>  m_on_destroy_callbacks;
-    std::vector<Callback>  m_on_construct_callbacks;
-    bool                   m_is_optimized = true;
+    std::vector<Component>       m_components;
+    std::vector<Tick>            m_ticks; // in the order of `dense()`, `Updated` tags don't keep them
+    std::vector<Callback>        m_on_destroy_callbacks;
+    std::vector<Callback>        m_on_construct_callbacks;
+    std::vector<Entity>          m_deferred; // emplaced while the construct callbacks are deferred
+    bool                         m_defer_callbacks = false;
+    bool                         m_is_optimized    = true;
+    std::optional<std::uint64_t> m_unused_since; // first frame the storage was seen with unused memory
 };
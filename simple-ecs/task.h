@@ -0,0 +1,226 @@
+#pragma once
+
+#include "simple-ecs/job_scheduler.h"
+#include "simple-ecs/utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+
+
+struct Task;
+
+namespace detail::task
+{
+
+struct WaitList;
+
+// intrusive link of suspended coroutine
+struct Node {
+    Node*     prev = nullptr;
+    Node*     next = nullptr;
+    WaitList* list = nullptr;
+};
+
+// intrusive list of suspended coroutines. Doesn't own anything and doesn't allocate
+struct WaitList final : NoCopyNoMove {
+    bool empty() const noexcept { return !m_head; }
+
+    void push(Node* node) noexcept {
+        assert(!node->list && "Coroutine is already suspended");
+
+        node->list = this;
+        node->prev = m_tail;
+        node->next = nullptr;
+        (m_tail ? m_tail->next : m_head) = node;
+        m_tail = node;
+    }
+
+    Node* pop() noexcept {
+        auto* node = m_head;
+        if (node) {
+            erase(node);
+        }
+        return node;
+    }
+
+    void erase(Node* node) noexcept {
+        assert(node->list == this);
+
+        (node->prev ? node->prev->next : m_head) = node->next;
+        (node->next ? node->next->prev : m_tail) = node->prev;
+        node->prev = node->next = nullptr;
+        node->list = nullptr;
+    }
+
+    // move all nodes to `other`
+    void moveTo(WaitList& other) noexcept {
+        while (auto* node = pop()) {
+            other.push(node);
+        }
+    }
+
+    // move the nodes matching `pred` to `other`, the order is kept
+    template<typename Pred>
+    void moveTo(WaitList& other, Pred&& pred) {
+        for (auto* node = m_head; node;) {
+            auto* next = node->next;
+            if (pred(*node)) {
+                erase(node);
+                other.push(node);
+            }
+            node = next;
+        }
+    }
+
+private:
+    Node* m_head = nullptr;
+    Node* m_tail = nullptr;
+};
+
+enum class Wait : std::uint8_t {
+    Frame,
+    Time,
+    Job,
+};
+
+} // namespace detail::task
+
+
+// Coroutine which can be registered as a system function and span several frames.
+// Suspended coroutines are resumed by `Registry::exec()` in the place of their function in the frame.
+//
+//   Task MySystem::spawnWave(OBSERVER(Filter) observer) {
+//       co_await m_registry->nextFrame();
+//       co_await m_registry->after(2s);
+//       co_await m_registry->async([this] { loadWave(); });
+//       observer.create<EnemyType>();
+//   }
+struct Task final : NoCopy {
+    struct promise_type : detail::task::Node {
+        promise_type() = default;
+        ~promise_type() {
+            if (list) { // destroyed while suspended
+                list->erase(this);
+            }
+        }
+
+        Task                get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void                return_void() noexcept {}
+        void                unhandled_exception() noexcept { std::terminate(); }
+
+        // true when the coroutine can be resumed
+        bool isReady(std::chrono::steady_clock::time_point now) const noexcept {
+            switch (wait) {
+            case detail::task::Wait::Frame: return true;
+            case detail::task::Wait::Time: return now >= wake_at;
+            case detail::task::Wait::Job: return job_done->load(std::memory_order_acquire);
+            }
+            return true;
+        }
+
+        detail::task::Wait                    wait = detail::task::Wait::Frame;
+        std::chrono::steady_clock::time_point wake_at;
+        std::shared_ptr<std::atomic_bool>     job_done;
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    ~Task() { reset(); }
+
+    bool done() const noexcept { return !m_handle || m_handle.done(); }
+
+    // resumes the coroutine if it is in the `ready` list. Suspended again, it waits in the list of the awaiter
+    void resume(detail::task::WaitList& ready) {
+        if (m_handle && !m_handle.done() && m_handle.promise().list == &ready) {
+            ready.erase(&m_handle.promise());
+            m_handle.resume();
+        }
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    void reset() noexcept {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+
+// registered functions can be regular functions or coroutines
+template<typename Result>
+concept EcsFunctionResult = std::disjunction_v<std::is_void<Result>, std::is_same<Result, Task>>;
+
+
+namespace detail::task
+{
+
+struct Awaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_resume() const noexcept {}
+
+    void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+        auto& promise   = handle.promise();
+        promise.wait    = wait;
+        promise.wake_at = wake_at;
+        list.push(&promise);
+    }
+
+    WaitList&                             list;
+    Wait                                  wait;
+    std::chrono::steady_clock::time_point wake_at{};
+};
+
+template<typename Callable>
+struct JobAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_resume() const noexcept {}
+
+    void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+        auto& promise    = handle.promise();
+        promise.wait     = Wait::Job;
+        promise.job_done = std::make_shared<std::atomic_bool>(false);
+        list.push(&promise);
+
+        jobs.post([job = std::move(job), done = promise.job_done]() mutable {
+            std::invoke(job);
+            done->store(true, std::memory_order_release);
+        });
+    }
+
+    WaitList&     list;
+    JobScheduler& jobs;
+    Callable      job;
+};
+
+// moves the coroutines which can be resumed in this frame to `ready`. Every coroutine is resumed by its function,
+// so the resumed code is ordered by phases and measured as a part of the frame
+inline void collect(WaitList& waiting, WaitList& ready) {
+    ECS_PROFILER(ZoneScoped);
+
+    if (waiting.empty()) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    waiting.moveTo(ready, [now](Node& node) { return static_cast<Task::promise_type&>(node).isReady(now); });
+}
+
+} // namespace detail::task
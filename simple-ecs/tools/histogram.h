@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+// Log-linear histogram of integer values in the spirit of HdrHistogram. Values are grouped by the power of two and
+// every group is split into `SUB_BUCKETS` linear buckets, so the relative error of a percentile is below 1/32.
+// Recording is a bit scan and an increment. Buckets are allocated on the first record, so an empty histogram is cheap.
+struct Histogram final {
+    static constexpr std::uint32_t SUB_BITS    = 5;
+    static constexpr std::uint64_t SUB_BUCKETS = 1U << SUB_BITS;
+    static constexpr std::size_t   BUCKETS     = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    void record(std::uint64_t value, std::uint64_t count = 1) {
+        if (!count) {
+            return;
+        }
+        if (m_counts.empty()) {
+            m_counts.resize(BUCKETS);
+        }
+
+        m_counts[index(value)] += count;
+        m_count += count;
+        m_sum += value * count;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void merge(const Histogram& other) {
+        if (other.empty()) {
+            return;
+        }
+        if (m_counts.empty()) {
+            m_counts.resize(BUCKETS);
+        }
+
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    void reset() noexcept {
+        std::ranges::fill(m_counts, 0);
+        m_count = 0;
+        m_sum   = 0;
+        m_min   = std::numeric_limits<std::uint64_t>::max();
+        m_max   = 0;
+    }
+
+    bool          empty() const noexcept { return m_count == 0; }
+    std::uint64_t count() const noexcept { return m_count; }
+    std::uint64_t sum() const noexcept { return m_sum; }
+    std::uint64_t min() const noexcept { return empty() ? 0 : m_min; }
+    std::uint64_t max() const noexcept { return m_max; }
+    double        mean() const noexcept { return empty() ? 0. : static_cast<double>(m_sum) / m_count; }
+
+    // the highest value of the bucket which holds the percentile, `percentile` is in [0, 100]
+    std::uint64_t percentile(double percentile) const noexcept {
+        if (empty()) {
+            return 0;
+        }
+
+        auto rank = static_cast<std::uint64_t>(std::clamp(percentile, 0., 100.) / 100. * m_count + 0.5);
+        rank      = std::clamp<std::uint64_t>(rank, 1, m_count);
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += m_counts[i];
+            if (seen >= rank) {
+                return std::clamp(highest(i), m_min, m_max);
+            }
+        }
+        return m_max;
+    }
+
+private:
+    // values below SUB_BUCKETS are exact, the others keep SUB_BITS bits after the highest one
+    static std::size_t index(std::uint64_t value) noexcept {
+        if (value < SUB_BUCKETS) {
+            return static_cast<std::size_t>(value);
+        }
+
+        auto shift = static_cast<std::uint32_t>(std::bit_width(value)) - SUB_BITS - 1;
+        return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static std::uint64_t highest(std::size_t index) noexcept {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+
+        auto shift = static_cast<std::uint32_t>(index / SUB_BUCKETS) - 1;
+        auto lower = (index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+        return lower + ((std::uint64_t{1} << shift) - 1);
+    }
+
+private:
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t              m_count = 0;
+    std::uint64_t              m_sum   = 0;
+    std::uint64_t              m_min   = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t              m_max   = 0;
+};
@@ -0,0 +1,168 @@
+#include "simple-ecs/tools/lz.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+
+namespace
+{
+
+constexpr std::size_t   MIN_MATCH   = 4;
+constexpr std::size_t   MAX_OFFSET  = 0xFFFF;
+constexpr std::size_t   LAST_BYTES  = 8; // tail is always literals, so the match search doesn't read past the end
+constexpr std::uint32_t HASH_BITS   = 12;
+constexpr std::uint8_t  LENGTH_MASK = 15;
+
+std::uint32_t read32(const char* ptr) noexcept {
+    std::uint32_t value = 0;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+std::uint32_t hash(std::uint32_t value) noexcept {
+    return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// lengths above 15 are continued by bytes, 255 means that one more byte follows
+void writeLength(std::size_t length, std::vector<char>& dst) {
+    for (; length >= 255; length -= 255) {
+        dst.push_back(static_cast<char>(255));
+    }
+    dst.push_back(static_cast<char>(length));
+}
+
+bool readLength(const char*& ip, const char* end, std::size_t& length) noexcept {
+    std::uint8_t byte = 0;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        byte = static_cast<std::uint8_t>(*ip++);
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void writeSequence(std::span<const char> literals, std::size_t offset, std::size_t match, std::vector<char>& dst) {
+    auto lit_token   = std::min<std::size_t>(literals.size(), LENGTH_MASK);
+    auto match_token = offset ? std::min<std::size_t>(match - MIN_MATCH, LENGTH_MASK) : 0;
+    dst.push_back(static_cast<char>((lit_token << 4) | match_token));
+
+    if (lit_token == LENGTH_MASK) {
+        writeLength(literals.size() - LENGTH_MASK, dst);
+    }
+    dst.insert(dst.end(), literals.begin(), literals.end());
+
+    if (!offset) {
+        return; // the last sequence has literals only
+    }
+
+    dst.push_back(static_cast<char>(offset & 0xFF));
+    dst.push_back(static_cast<char>(offset >> 8));
+    if (match_token == LENGTH_MASK) {
+        writeLength(match - MIN_MATCH - LENGTH_MASK, dst);
+    }
+}
+
+} // namespace
+
+
+namespace lz
+{
+
+void compress(std::span<const char> src, std::vector<char>& dst) {
+    const char* data   = src.data();
+    std::size_t anchor = 0;
+
+    if (src.size() > LAST_BYTES + MIN_MATCH) {
+        // positions are stored + 1, so 0 is empty
+        thread_local std::array<std::uint32_t, 1U << HASH_BITS> table;
+        table.fill(0);
+
+        const std::size_t limit  = src.size() - LAST_BYTES;
+        std::size_t       misses = 0; // incompressible data is scanned with larger steps
+        for (std::size_t i = 0; i < limit;) {
+            auto  value     = read32(data + i);
+            auto& slot      = table[hash(value)];
+            auto  candidate = static_cast<std::size_t>(slot) - 1;
+            slot            = static_cast<std::uint32_t>(i + 1);
+
+            if (candidate >= i || i - candidate > MAX_OFFSET || read32(data + candidate) != value) {
+                i += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            auto end = i + MIN_MATCH;
+            while (end < limit && data[end] == data[end - i + candidate]) {
+                ++end;
+            }
+
+            writeSequence(src.subspan(anchor, i - anchor), i - candidate, end - i, dst);
+            i      = end;
+            anchor = end;
+        }
+    }
+
+    writeSequence(src.subspan(anchor), 0, 0, dst);
+}
+
+bool decompress(std::span<const char> src, std::span<char> dst) noexcept {
+    const char* ip  = src.data();
+    const char* end = src.data() + src.size();
+    std::size_t op  = 0;
+
+    while (ip != end) {
+        auto token = static_cast<std::uint8_t>(*ip++);
+
+        std::size_t literals = token >> 4;
+        if (literals == LENGTH_MASK && !readLength(ip, end, literals)) {
+            return false;
+        }
+        if (literals > static_cast<std::size_t>(end - ip) || literals > dst.size() - op) {
+            return false;
+        }
+        if (literals) {
+            std::memcpy(dst.data() + op, ip, literals);
+        }
+        ip += literals;
+        op += literals;
+
+        if (ip == end) {
+            break; // the last sequence
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        std::size_t offset = static_cast<std::uint8_t>(ip[0]);
+        offset |= static_cast<std::size_t>(static_cast<std::uint8_t>(ip[1])) << 8;
+        ip += 2;
+
+        std::size_t match = token & LENGTH_MASK;
+        if (match == LENGTH_MASK && !readLength(ip, end, match)) {
+            return false;
+        }
+        match += MIN_MATCH;
+
+        if (!offset || offset > op || match > dst.size() - op) {
+            return false;
+        }
+
+        // the match can overlap the output, then it repeats the last `offset` bytes
+        if (offset >= match) {
+            std::memcpy(dst.data() + op, dst.data() + op - offset, match);
+            op += match;
+        } else {
+            for (std::size_t i = 0; i < match; ++i, ++op) {
+                dst[op] = dst[op - offset];
+            }
+        }
+    }
+
+    return op == dst.size();
+}
+
+} // namespace lz
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+
+// Byte oriented LZ77 codec in the spirit of LZ4. Data is a sequence of `[token][literals][offset][match]`,
+// where the token keeps the lengths of the literals and the match, and the offset points back up to 64KB.
+// It's fast rather than strong: one hash probe per position and no entropy coding.
+namespace lz
+{
+
+// the largest size of the compressed data
+constexpr std::size_t bound(std::size_t size) noexcept {
+    return size + size / 255 + 16;
+}
+
+// the largest size of the data decompressed from `size` bytes, a length byte adds at most 255 bytes
+constexpr std::size_t maxDecompressed(std::size_t size) noexcept {
+    return size * 255;
+}
+
+// appends the compressed `src` to `dst`
+void compress(std::span<const char> src, std::vector<char>& dst);
+
+// `dst` must have the size of the original data. Returns false if the data is corrupted
+[[nodiscard]] bool decompress(std::span<const char> src, std::span<char> dst) noexcept;
+
+} // namespace lz
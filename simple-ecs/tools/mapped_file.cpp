@@ -0,0 +1,98 @@
+#include "simple-ecs/tools/mapped_file.h"
+
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        spdlog::error("Cannot open {}", path.string());
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    // the mapping keeps the file open
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        spdlog::error("Cannot map {}", path.string());
+        return;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        spdlog::error("Cannot map {}", path.string());
+        CloseHandle(mapping);
+        return;
+    }
+
+    m_data   = static_cast<const char*>(view);
+    m_size   = static_cast<std::size_t>(size.QuadPart);
+    m_handle = mapping;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_handle);
+    }
+    m_data   = nullptr;
+    m_size   = 0;
+    m_handle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("Cannot open {}", path.string());
+        return;
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return;
+    }
+
+    // the mapping keeps the file open
+    void* view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        spdlog::error("Cannot map {}", path.string());
+        return;
+    }
+
+    m_data = static_cast<const char*>(view);
+    m_size = static_cast<std::size_t>(info.st_size);
+}
+
+void MappedFile::close() noexcept {
+    if (m_data) {
+        ::munmap(const_cast<char*>(m_data), m_size); // NOLINT
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
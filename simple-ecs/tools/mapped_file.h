@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+
+// Read only memory mapping of the whole file. Pages are loaded by OS on the first access.
+struct MappedFile final {
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path);
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr))
+      , m_size(std::exchange(other.m_size, 0))
+      , m_handle(std::exchange(other.m_handle, nullptr)) {}
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data   = std::exchange(other.m_data, nullptr);
+            m_size   = std::exchange(other.m_size, 0);
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    ~MappedFile() { close(); }
+
+    bool                  isOpen() const noexcept { return m_data != nullptr; }
+    std::span<const char> data() const noexcept { return {m_data, m_size}; }
+
+    void close() noexcept;
+
+private:
+    const char* m_data   = nullptr;
+    std::size_t m_size   = 0;
+    void*       m_handle = nullptr; // mapping object on Windows
+};
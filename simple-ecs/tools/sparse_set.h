@@ -3,6 +3,7 @@
 #include "simple-ecs/entity.h"
 #include "simple-ecs/utils.h"
 #include <cassert>
+#include <span>
 #include <vector>
 
 
@@ -39,6 +40,9 @@ struct SparseSet {
 
     decltype(auto) size() const noexcept { return m_dense.size(); }
 
+    // entities in the order of the dense arrays
+    std::span<const Entity> dense() const noexcept { return m_dense; }
+
 protected:
     std::vector<Entity> m_dense;
     std::vector<Entity> m_sparse;
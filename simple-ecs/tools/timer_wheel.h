@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+// Hierarchical timer wheel. Every level has 64 slots and each slot of the level covers all slots of the previous one.
+// Timers of the far levels are moved (cascaded) to the closer ones when the current tick reaches their slot.
+// Timers beyond the last level are kept in the overflow list and are placed again when the last level wraps.
+template<typename T, std::size_t Levels = 4>
+struct TimerWheel final {
+    using Tick = std::uint64_t;
+
+    static constexpr Tick NEVER = std::numeric_limits<Tick>::max();
+
+    explicit TimerWheel(Tick now = 0) : m_now(now) {}
+
+    Tick        now() const noexcept { return m_now; }
+    std::size_t size() const noexcept { return m_size; }
+    bool        empty() const noexcept { return m_size == 0; }
+
+    // timers in the past will be fired on the next tick
+    void add(Tick expire, T value) {
+        place({expire, std::move(value)});
+        ++m_size;
+    }
+
+    // move the wheel to `target` tick and call `on_expire` for all expired timers
+    template<typename Callback>
+    void advance(Tick target, Callback&& on_expire) {
+        if (empty()) {
+            m_now = std::max(m_now, target);
+            return;
+        }
+
+        while (m_now < target) {
+            ++m_now;
+
+            if ((m_now & mask(Levels)) == 0) {
+                cascade(m_overflow);
+            }
+
+            for (std::size_t level = 1; level < Levels && (m_now & mask(level)) == 0; ++level) {
+                cascade(m_slots[level][index(m_now, level)]);
+            }
+
+            auto& slot = m_slots[0][index(m_now, 0)];
+            if (slot.empty()) {
+                continue;
+            }
+
+            m_fired.swap(slot);
+            m_size -= m_fired.size();
+            for (auto& timer : m_fired) {
+                on_expire(std::move(timer.value));
+            }
+            m_fired.clear();
+        }
+    }
+
+    // the closest tick when `advance` can fire or cascade timers
+    Tick nextTick() const noexcept {
+        if (empty()) {
+            return NEVER;
+        }
+
+        for (Tick tick = m_now + 1; tick <= (m_now | mask(1)); ++tick) {
+            if (!m_slots[0][index(tick, 0)].empty()) {
+                return tick;
+            }
+        }
+
+        for (std::size_t level = 1; level < Levels; ++level) {
+            for (auto slot = index(m_now, level) + 1; slot < SLOTS; ++slot) {
+                if (!m_slots[level][slot].empty()) {
+                    return (m_now & ~mask(level + 1)) | (static_cast<Tick>(slot) << (SLOT_BITS * level));
+                }
+            }
+        }
+
+        return (m_now | mask(Levels)) + 1;
+    }
+
+private:
+    static constexpr std::size_t SLOT_BITS = 6;
+    static constexpr std::size_t SLOTS     = 1 << SLOT_BITS;
+
+    struct Timer {
+        Tick expire;
+        T    value;
+    };
+
+    static constexpr Tick        mask(std::size_t level) noexcept { return (Tick(1) << (SLOT_BITS * level)) - 1; }
+    static constexpr std::size_t index(Tick tick, std::size_t level) noexcept {
+        return (tick >> (SLOT_BITS * level)) & mask(1);
+    }
+
+    void place(Timer&& timer) {
+        // the level is defined by the highest bits which differ from the current tick
+        Tick expire = std::max(timer.expire, m_now + 1);
+        Tick diff   = expire ^ m_now;
+
+        if (diff > mask(Levels)) {
+            m_overflow.emplace_back(std::move(timer));
+            return;
+        }
+
+        auto level = (std::bit_width(diff) - 1) / SLOT_BITS;
+        m_slots[level][index(expire, level)].emplace_back(std::move(timer));
+    }
+
+    void cascade(std::vector<Timer>& slot) {
+        if (slot.empty()) {
+            return;
+        }
+
+        m_cascade.swap(slot);
+        for (auto& timer : m_cascade) {
+            if (timer.expire <= m_now) {
+                // timers of the current tick, its slot is fired right after the cascade
+                m_slots[0][index(m_now, 0)].emplace_back(std::move(timer));
+            } else {
+                place(std::move(timer));
+            }
+        }
+        m_cascade.clear();
+    }
+
+private:
+    std::array<std::array<std::vector<Timer>, SLOTS>, Levels> m_slots;
+    std::vector<Timer>                                        m_overflow;
+    std::vector<Timer>                                        m_cascade;
+    std::vector<Timer>                                        m_fired;
+    Tick                                                      m_now  = 0;
+    std::size_t                                               m_size = 0;
+};
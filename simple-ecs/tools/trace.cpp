@@ -0,0 +1,141 @@
+#include "simple-ecs/tools/trace.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace
+{
+
+// written only by the owner thread. Readers copy the events and drop the ones which could be overwritten meanwhile
+struct Buffer {
+    Buffer(std::size_t capacity, std::uint32_t thread) : events(std::max<std::size_t>(capacity, 1)), thread(thread) {}
+
+    std::vector<TraceEvent> events;
+    std::atomic_uint64_t    head = 0; // events written since the start
+    const std::uint32_t     thread;
+};
+
+struct Buffers {
+    std::mutex                           mutex;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    std::uint32_t                        next_thread = 0;
+};
+
+Buffers& buffers() {
+    static Buffers buffers;
+    return buffers;
+}
+
+// the buffer is registered on the first zone of the thread, buffers of finished threads are dropped then
+Buffer& threadBuffer() {
+    thread_local std::shared_ptr<Buffer> buffer = [] {
+        auto& all = buffers();
+
+        std::lock_guard _(all.mutex);
+        std::erase_if(all.buffers, [](const auto& buffer) { return buffer.use_count() == 1; });
+        return all.buffers.emplace_back(std::make_shared<Buffer>(Trace::capacity, all.next_thread++));
+    }();
+    return *buffer;
+}
+
+void escape(std::string& out, std::string_view name) {
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<int>(c));
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+
+void Trace::record(const TraceEvent& event) noexcept {
+    auto& buffer = threadBuffer();
+
+    auto head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % buffer.events.size()] = event;
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::string Trace::dump(std::chrono::nanoseconds time) {
+    struct ThreadEvent {
+        TraceEvent    event;
+        std::uint32_t thread;
+    };
+
+    std::vector<ThreadEvent> events;
+    const auto               now  = detail::trace::now();
+    const auto               from = now - std::min<std::uint64_t>(now, static_cast<std::uint64_t>(time.count()));
+
+    std::vector<std::shared_ptr<Buffer>> all;
+    {
+        std::lock_guard _(buffers().mutex);
+        all = buffers().buffers;
+    }
+
+    std::vector<TraceEvent> copy;
+    for (const auto& buffer : all) {
+        const auto size  = buffer->events.size();
+        const auto head  = buffer->head.load(std::memory_order_acquire);
+        const auto first = head - std::min<std::uint64_t>(head, size);
+
+        copy.clear();
+        for (auto i = first; i < head; ++i) {
+            copy.emplace_back(buffer->events[i % size]);
+        }
+
+        // the owner could wrap around while we were copying. The slot of `after` can be in the middle of a write
+        const auto after = buffer->head.load(std::memory_order_acquire);
+        const auto valid = after + 1 > size ? after + 1 - size : 0;
+        for (auto i = std::max(first, valid); i < head; ++i) {
+            const auto& event = copy[i - first];
+            if (event.start + event.duration >= from) {
+                events.emplace_back(event, buffer->thread);
+            }
+        }
+    }
+
+    std::ranges::sort(events, {}, [](const auto& event) { return event.event.start; });
+
+    std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+    auto        it  = std::back_inserter(out);
+    for (const auto& [event, thread] : events) {
+        out += &event == &events.front().event ? R"({"name":")" : R"(,{"name":")";
+        escape(out, event.name);
+        fmt::format_to(it,
+                       R"(","cat":"ecs","ph":"X","pid":0,"tid":{},"ts":{:.3f},"dur":{:.3f})",
+                       thread,
+                       static_cast<double>(event.start) / 1000.,
+                       static_cast<double>(event.duration) / 1000.);
+        if (event.id) {
+            fmt::format_to(it, R"(,"args":{{"id":{}}})", event.id);
+        }
+        out += '}';
+    }
+    out += "]}\n";
+
+    return out;
+}
+
+bool Trace::dump(const std::filesystem::path& path, std::chrono::nanoseconds time) {
+    auto          trace = dump(time);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(trace.data(), static_cast<std::streamsize>(trace.size()))) {
+        spdlog::error("Cannot write trace to {}", path.string());
+        return false;
+    }
+    return true;
+}
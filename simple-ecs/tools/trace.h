@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+
+#define ECS_TRACE_CONCAT_IMPL(x, y) x##y
+#define ECS_TRACE_CONCAT(x, y) ECS_TRACE_CONCAT_IMPL(x, y)
+
+// ECS_TRACE("name") or ECS_TRACE(name, id). The name must outlive the trace, e.g. a string literal
+#define ECS_TRACE(...) TraceZone ECS_TRACE_CONCAT(ecs_trace_zone_, __COUNTER__){__VA_ARGS__}
+
+
+struct TraceEvent {
+    std::string_view name;
+    std::uint64_t    id       = 0; // e.g. crc of the function name in the final build
+    std::uint64_t    start    = 0; // steady clock, ns
+    std::uint64_t    duration = 0; // ns
+};
+
+
+namespace detail::trace
+{
+
+inline std::atomic_bool enabled = false;
+
+inline std::uint64_t now() noexcept {
+    using namespace std::chrono;
+    return static_cast<std::uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace detail::trace
+
+
+// Zones are written to a ring buffer of the calling thread without locks, the oldest ones are overwritten.
+// Recording is off by default and a disabled zone costs one relaxed load.
+struct Trace final {
+    static inline std::size_t capacity = 1U << 15; // zones per thread, set it before the first zone
+
+    static void enable(bool enabled) noexcept { detail::trace::enabled.store(enabled, std::memory_order_relaxed); }
+    static bool enabled() noexcept { return detail::trace::enabled.load(std::memory_order_relaxed); }
+
+    static void record(const TraceEvent& event) noexcept;
+
+    // Chrome trace event JSON of the zones finished in the last `time`, opens in chrome://tracing and Perfetto.
+    // Zones being written during the dump are skipped
+    static std::string dump(std::chrono::nanoseconds time);
+    static bool        dump(const std::filesystem::path& path, std::chrono::nanoseconds time);
+};
+
+
+struct TraceZone final {
+    explicit TraceZone(std::string_view name, std::uint64_t id = 0) noexcept
+      : m_name(name), m_id(id), m_start(Trace::enabled() ? detail::trace::now() : 0) {}
+
+    TraceZone(const TraceZone&)            = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    ~TraceZone() {
+        if (m_start) {
+            Trace::record({m_name, m_id, m_start, detail::trace::now() - m_start});
+        }
+    }
+
+private:
+    std::string_view m_name;
+    std::uint64_t    m_id;
+    std::uint64_t    m_start; // zero if the trace was disabled at the start
+};
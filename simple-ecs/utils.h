@@ -2,6 +2,7 @@
 
 #include "simple-ecs/entity.h"
 #include "simple-ecs/tools/profiler.h" // IWYU pragma: export
+#include "simple-ecs/tools/trace.h"    // IWYU pragma: export
 #include <spdlog/spdlog.h>
 #include <ct/names.h>
 #include <tmp_buffer/tmp_buffer.h>
@@ -2,11 +2,221 @@
 #include "simple-ecs/entity_debug.h"
 #include "simple-ecs/registry.h"
 
+#include <spdlog/fmt/fmt.h>
 
-World::World() {
-    static bool exists = false;
-    assert(!std::exchange(exists, true) && "You cannot create more than one world");
+#include <array>
+#include <iterator>
+
+
+namespace
+{
+
+enum class SnapshotDiff { None, Values, All };
 
+// Part of the storage which differs from its copy in the snapshot. Entities are emplaced or erased since the copy
+// if the version was changed, otherwise only the components stamped since the copy differ
+SnapshotDiff snapshotDiff(const StorageBase& storage, const detail::world::Snapshot& state, std::size_t index) {
+    if (state.versions[index] != storage.version()) {
+        return SnapshotDiff::All;
+    }
+    return storage.changedSince(state.ticks[index]) ? SnapshotDiff::Values : SnapshotDiff::None;
+}
+
+void copyDiff(const StorageBase& source, StorageBase& target, SnapshotDiff diff) {
+    if (diff == SnapshotDiff::All) {
+        source.copyTo(target);
+    } else if (diff == SnapshotDiff::Values) {
+        source.copyValuesTo(target);
+    }
+}
+
+} // namespace
+
+
+World::World() {
     m_reg = std::make_unique<Registry>(*this);
     m_reg->addSystem<EntityDebugSystem>(*this);
 }
+
+SnapshotHandle World::snapshot() {
+    ECS_PROFILER(ZoneScoped);
+
+    for (std::size_t i = 0; i < m_storages.size(); ++i) {
+        if (m_storages[i] && !m_storages[i]->copyable()) {
+            auto component = std::ranges::find_if(m_component_name, [this, i](const auto& name_id) {
+                return m_component_storages.at(name_id.second).first == i;
+            });
+            spdlog::error("World snapshot is not taken, {} can't be copied",
+                          component == m_component_name.end() ? fmt::format("storage {}", i) : component->first);
+            return INVALID_SNAPSHOT;
+        }
+    }
+
+    auto  handle = m_next_snapshot++;
+    auto& state  = m_snapshots[handle % detail::world::SNAPSHOTS];
+
+    state.entities            = m_entities;
+    state.entities_to_destroy = m_entities_to_destroy;
+    state.free_entities.assign(m_free_entities.begin(), m_free_entities.end());
+
+    state.storages.resize(std::max(state.storages.size(), m_storages.size()));
+    state.versions.resize(state.storages.size());
+    state.ticks.resize(state.storages.size());
+    for (std::size_t i = 0; i < m_storages.size(); ++i) {
+        if (!m_storages[i]) {
+            continue; // component of another world
+        }
+
+        auto diff = SnapshotDiff::All;
+        if (!state.storages[i]) {
+            state.storages[i] = m_storages[i]->makeEmpty();
+        } else if (diff = snapshotDiff(*m_storages[i], state, i); diff == SnapshotDiff::None) {
+            continue; // copy of the previous round is still the same
+        }
+        copyDiff(*m_storages[i], *state.storages[i], diff);
+        state.versions[i] = m_storages[i]->version();
+        state.ticks[i]    = m_tick;
+    }
+
+    return handle;
+}
+
+bool World::restore(SnapshotHandle handle) {
+    ECS_PROFILER(ZoneScoped);
+
+    if (handle >= m_next_snapshot || m_next_snapshot - handle > detail::world::SNAPSHOTS) {
+        spdlog::error("Snapshot {} is not available, {} snapshots were taken", handle, m_next_snapshot);
+        return false;
+    }
+
+    auto& state = m_snapshots[handle % detail::world::SNAPSHOTS];
+
+    auto changed = TMP_GET(std::vector<Entity>);
+    if (!m_notify_callback.empty()) {
+        std::ranges::set_union(m_entities, state.entities, std::back_inserter(*changed));
+    }
+
+    m_entities            = state.entities;
+    m_entities_to_destroy = state.entities_to_destroy;
+    m_free_entities.assign(state.free_entities.begin(), state.free_entities.end());
+
+    for (std::size_t i = 0; i < m_storages.size(); ++i) {
+        if (!m_storages[i]) {
+            continue;
+        }
+        if (i < state.storages.size() && state.storages[i]) {
+            auto diff = snapshotDiff(*m_storages[i], state, i);
+            if (diff == SnapshotDiff::None) {
+                continue; // nothing was changed since the snapshot
+            }
+            copyDiff(*state.storages[i], *m_storages[i], diff);
+        } else {
+            // storage was created after the snapshot
+            m_storages[i]->makeEmpty()->copyTo(*m_storages[i]);
+        }
+        m_storages[i]->markChanged(); // restored components differ from the ones seen by the observers
+    }
+
+    notify(*changed);
+    return true;
+}
+
+MemoryReport World::memoryReport() const {
+    ECS_PROFILER(ZoneScoped);
+
+    auto stats = [this](IDType storage_id) {
+        return storage_id < m_storages.size() && m_storages[storage_id] ? m_storages[storage_id]->memoryStats()
+                                                                         : MemoryStats{};
+    };
+
+    MemoryReport report;
+    report.components.reserve(m_component_name.size());
+    for (const auto& [name, id] : m_component_name) {
+        const auto& [storage_id, updated_id] = m_component_storages.at(id);
+        report.components.emplace_back(name, id, stats(storage_id), stats(updated_id));
+    }
+
+    // free ids are kept in the blocks of a deque
+    const auto free_entities = m_free_entities.size() * sizeof(Entity);
+
+    report.entities = {(m_entities.size() + m_entities_to_destroy.size()) * sizeof(Entity) + free_entities,
+                       (m_entities.capacity() + m_entities_to_destroy.capacity()) * sizeof(Entity) + free_entities};
+    report.observers = m_reg->observersMemory();
+
+    for (const auto& snapshot : m_snapshots) {
+        for (const auto* entities : {&snapshot.entities, &snapshot.entities_to_destroy, &snapshot.free_entities}) {
+            report.snapshots.entities += {entities->size() * sizeof(Entity), entities->capacity() * sizeof(Entity)};
+        }
+        for (const auto& storage : snapshot.storages) {
+            if (storage) {
+                report.snapshots += storage->memoryStats();
+            }
+        }
+    }
+
+    return report;
+}
+
+std::size_t MemoryReport::used() const noexcept {
+    std::size_t result = entities.used + observers.used + snapshots.used();
+    for (const auto& component : components) {
+        result += component.used();
+    }
+    return result;
+}
+
+std::size_t MemoryReport::capacity() const noexcept {
+    std::size_t result = entities.capacity + observers.capacity + snapshots.capacity();
+    for (const auto& component : components) {
+        result += component.capacity();
+    }
+    return result;
+}
+
+namespace
+{
+
+std::string bytes(std::size_t size) {
+    constexpr std::array UNITS = {"B", "KB", "MB", "GB"};
+
+    auto        value = static_cast<double>(size);
+    std::size_t unit  = 0;
+    while (value >= 1024. && unit + 1 < UNITS.size()) {
+        value /= 1024.;
+        ++unit;
+    }
+    return unit ? fmt::format("{:.1f} {}", value, UNITS[unit]) : fmt::format("{} B", size);
+}
+
+void row(std::string& out, std::string_view name, std::size_t size, std::size_t used, std::size_t capacity) {
+    auto fragmentation = capacity ? 100. * (1. - static_cast<double>(used) / capacity) : 0.;
+    fmt::format_to(std::back_inserter(out),
+                   "{:<40} {:>10} {:>12} {:>12} {:>8.1f}%\n",
+                   name,
+                   size,
+                   bytes(used),
+                   bytes(capacity),
+                   fragmentation);
+}
+
+} // namespace
+
+std::string dumpMemoryReport(const MemoryReport& report) {
+    std::string out = fmt::format("Memory: {} used, {} allocated\n", bytes(report.used()), bytes(report.capacity()));
+    fmt::format_to(std::back_inserter(out),
+                   "{:<40} {:>10} {:>12} {:>12} {:>9}\n",
+                   "component",
+                   "size",
+                   "used",
+                   "allocated",
+                   "unused");
+
+    for (const auto& component : report.components) {
+        row(out, component.name, component.storage.size, component.used(), component.capacity());
+    }
+    row(out, "[entities]", 0, report.entities.used, report.entities.capacity);
+    row(out, "[observers]", 0, report.observers.used, report.observers.capacity);
+    row(out, "[snapshots]", report.snapshots.size, report.snapshots.used(), report.snapshots.capacity());
+
+    return out;
+}
@@ -6,20 +6,28 @@
 #include "simple-ecs/utils.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
-#include <list>
+#include <deque>
+#include <limits>
 #include <map>
 #include <memory>
 #include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 
 namespace detail::world
 {
 
+// ids are shared by all worlds, so storages of a world are indexed by the same id. Worlds can be created on any thread
 inline IDType nextID() {
-    static IDType id = 0;
-    return id++;
+    static std::atomic<IDType> id = 0;
+    return id.fetch_add(1, std::memory_order_relaxed);
 }
 
 template<typename T>
@@ -28,9 +36,51 @@ inline IDType sequenceID() {
     return id;
 };
 
+// snapshots kept for restore, the oldest one is overwritten
+constexpr std::size_t SNAPSHOTS = 8;
+
+struct Snapshot {
+    std::vector<Entity>                       entities;
+    std::vector<Entity>                       entities_to_destroy;
+    std::vector<Entity>                       free_entities;
+    std::vector<std::unique_ptr<StorageBase>> storages; // copies, allocated once and reused
+    std::vector<std::uint64_t>                versions; // of the copied storages, unchanged ones are not copied again
+    std::vector<Tick>                         ticks;    // world tick of the copy, later changes need a new one
+};
+
 } // namespace detail::world
 
 
+using SnapshotHandle = std::uint64_t;
+
+// returned by `World::snapshot` if the world can't be copied
+constexpr SnapshotHandle INVALID_SNAPSHOT = std::numeric_limits<SnapshotHandle>::max();
+
+
+struct ComponentMemory {
+    std::string_view name;
+    Component        id = 0;
+    MemoryStats      storage;
+    MemoryStats      updated; // Updated<Component> tags
+
+    std::size_t used() const noexcept { return storage.used() + updated.used(); }
+    std::size_t capacity() const noexcept { return storage.capacity() + updated.capacity(); }
+};
+
+struct MemoryReport {
+    std::vector<ComponentMemory> components; // in the order of `registeredComponentNames`
+    MemoryBlock                  entities;   // alive, destroyed at the end of the frame and free ids
+    MemoryBlock                  observers;  // cached entities of the observers
+    MemoryStats                  snapshots;  // storages and entities of `World::snapshot`
+
+    std::size_t used() const noexcept;
+    std::size_t capacity() const noexcept;
+};
+
+// text table for logs and headless servers
+std::string dumpMemoryReport(const MemoryReport& report);
+
+
 struct Registry;
 
 struct World final : NoCopyNoMove {
@@ -43,9 +93,12 @@ struct World final : NoCopyNoMove {
     decltype(auto) size() const noexcept { return m_entities.size(); }
     decltype(auto) empty() const noexcept { return m_entities.empty(); }
 
-    std::size_t                             totalComponents() const noexcept { return m_storages.size(); }
     const std::vector<Entity>&              entities() const noexcept { return m_entities; }
     const std::map<std::string, Component>& registeredComponentNames() const noexcept { return m_component_name; }
+    std::size_t                             totalComponents() const noexcept {
+        auto exists = [](const auto& storage) { return storage != nullptr; };
+        return static_cast<std::size_t>(std::ranges::count_if(m_storages, exists));
+    }
     bool isAlive(Entity e) const noexcept { return std::ranges::binary_search(m_entities, e); }
     bool isAlive(std::span<const Entity> ents) const noexcept {
         bool result = true;
@@ -59,7 +112,7 @@ struct World final : NoCopyNoMove {
     void addEmplaceCallback(Storage<Component>::Callback&& f) {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         storage->addEmplaceCallback(std::move(f));
     }
@@ -68,7 +121,7 @@ struct World final : NoCopyNoMove {
     void addDestroyCallback(Storage<Component>::Callback&& f) {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         storage->addDestroyCallback(std::move(f));
     }
@@ -77,7 +130,7 @@ struct World final : NoCopyNoMove {
     decltype(auto) size() const noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         return storage->size();
     }
@@ -86,35 +139,53 @@ struct World final : NoCopyNoMove {
     decltype(auto) empty() const noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         return storage->empty();
     }
 
 
+    template<typename Component>
+    bool hasStorage() const noexcept {
+        auto id = detail::world::sequenceID<Component>();
+        return id < m_storages.size() && m_storages[id];
+    }
+
     template<typename Component>
     void createStorage() {
         ECS_PROFILER(ZoneScoped);
 
-        auto add_storage = [this]<typename T>() {
-            // generate runtime ID for components.
-            std::ignore = detail::world::sequenceID<T>();
-            ECS_ASSERT(m_storages.size() == detail::world::sequenceID<T>(), "Storage already exists");
-            m_storages.emplace_back(std::make_unique<Storage<T>>());
-        };
-
-        add_storage.template operator()<Component>();
-        add_storage.template operator()<Updated<Component>>();
+        addStorage<Component>();
 
         auto [_, was_added] = m_component_name.try_emplace(std::string(ct::NAME<Component>), ct::ID<Component>);
         assert(was_added);
+        m_component_storages.try_emplace(ct::ID<Component>,
+                                         detail::world::sequenceID<Component>(),
+                                         detail::world::sequenceID<Updated<Component>>());
+    }
+
+    // Creates the storage of `Updated<Component>` tags. The first `markUpdated` and a registered filter with
+    // `Updated<Component>` call it, so untagged components don't pay for it. Loaded components are tagged only
+    // if the storage exists
+    template<typename Component>
+    void trackUpdates() {
+        ECS_PROFILER(ZoneScoped);
+
+        if (!hasStorage<Updated<Component>>()) {
+            addStorage<Updated<Component>>();
+        }
     }
 
     template<typename Component, EcsTarget Target>
     ECS_FORCEINLINE bool has(Target target) noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        if constexpr (IS_UPDATED<Component>) {
+            if (!hasStorage<Component>()) {
+                return false; // nothing was tagged yet
+            }
+        }
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         ECS_ASSERT(isAlive(target), "Entity doesn't exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         return storage->has(target);
@@ -126,7 +197,7 @@ struct World final : NoCopyNoMove {
     ECS_FORCEINLINE void emplace(Target target, Component&& c) {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Type>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Type>(), "Storage doesn\'t exist");
         ECS_ASSERT(isAlive(target), "Entity doesn't exist");
         auto* storage = static_cast<Storage<Type>*>(m_storages.at(detail::world::sequenceID<Type>()).get());
         storage->emplace(target, std::forward<Component>(c));
@@ -137,7 +208,7 @@ struct World final : NoCopyNoMove {
     ECS_FORCEINLINE void emplace(Target target, Args&&... args) {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         ECS_ASSERT(isAlive(target), "Entity doesn't exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         storage->emplace(target, std::forward<Args>(args)...);
@@ -167,47 +238,75 @@ struct World final : NoCopyNoMove {
 
         using Tag = Updated<Component>;
         ECS_ASSERT(has<Component>(target), "Entity should have Component before you can marked it as Updated");
+        storage<Component>().markChanged(target);
+        trackUpdates<Component>();
         emplace<Tag>(target);
     }
 
+    // stamps the components with the current tick, `Changed<Component>` filters match them on the next refresh.
+    // Unlike `markUpdated` it is one store per component, nothing has to be cleared
+    template<typename Component, EcsTarget Target>
+    ECS_FORCEINLINE void markChanged(Target target) noexcept {
+        ECS_PROFILER(ZoneScoped);
+
+        ECS_ASSERT(isAlive(target), "Entity doesn't exist");
+        storage<Component>().markChanged(target);
+    }
+
     template<typename Component, EcsTarget Target>
     ECS_FORCEINLINE void clearUpdateTag(Target target) {
         ECS_PROFILER(ZoneScoped);
 
         using Tag = Updated<Component>;
-        erase<Tag>(target);
+        if (hasStorage<Tag>()) {
+            erase<Tag>(target);
+        }
     }
 
     template<typename Component, EcsTarget Target>
     ECS_FORCEINLINE void erase(Target target) {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         ECS_ASSERT(isAlive(target), "Entity doesn't exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         storage->erase(target);
         notify(target);
     }
 
-    template<typename Component>
+    // Non-const access is a write: `get<T>` and `tryGet<T>` stamp the component with the current tick like
+    // `getChanged`, so `Changed<T>` filters, deltas and snapshots see it. `get<const T>` reads and keeps the tick
+    template<typename Component, typename Type = std::remove_const_t<Component>>
     requires(!std::is_empty_v<Component>)
     [[nodiscard]] ECS_FORCEINLINE decltype(auto) get(Entity e) noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Type>(), "Storage doesn\'t exist");
         ECS_ASSERT(isAlive(e), "Entity doesn't exist");
-        auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
+        using Pointer = std::conditional_t<std::is_const_v<Component>, const Storage<Type>*, Storage<Type>*>;
+        auto* storage = static_cast<Pointer>(m_storages.at(detail::world::sequenceID<Type>()).get());
         return storage->get(e);
     }
 
+    // get for writing, the component is marked as changed
     template<typename Component>
     requires(!std::is_empty_v<Component>)
+    [[nodiscard]] ECS_FORCEINLINE decltype(auto) getChanged(Entity e) noexcept {
+        ECS_PROFILER(ZoneScoped);
+
+        ECS_ASSERT(isAlive(e), "Entity doesn't exist");
+        return storage<Component>().getChanged(e);
+    }
+
+    template<typename Component, typename Type = std::remove_const_t<Component>>
+    requires(!std::is_empty_v<Component>)
     [[nodiscard]] ECS_FORCEINLINE decltype(auto) tryGet(Entity e) noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Type>(), "Storage doesn\'t exist");
         ECS_ASSERT(isAlive(e), "Entity doesn't exist");
-        auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
+        using Pointer = std::conditional_t<std::is_const_v<Component>, const Storage<Type>*, Storage<Type>*>;
+        auto* storage = static_cast<Pointer>(m_storages.at(detail::world::sequenceID<Type>()).get());
         return storage->tryGet(e);
     }
 
@@ -215,11 +314,32 @@ struct World final : NoCopyNoMove {
     [[nodiscard]] const std::vector<Entity>& entities() const noexcept {
         ECS_PROFILER(ZoneScoped);
 
-        ECS_ASSERT(m_storages.size() > detail::world::sequenceID<Component>(), "Storage doesn't exist");
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
         auto* storage = static_cast<Storage<Component>*>(m_storages.at(detail::world::sequenceID<Component>()).get());
         return storage->entities();
     }
 
+    template<typename Component>
+    [[nodiscard]] Storage<Component>& storage() noexcept {
+        if constexpr (IS_UPDATED<Component>) {
+            trackUpdates<RemoveTag_t<Component>>();
+        }
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
+        return *static_cast<Storage<Component>*>(m_storages[detail::world::sequenceID<Component>()].get());
+    }
+
+    template<typename Component>
+    [[nodiscard]] const Storage<Component>& storage() const noexcept {
+        if constexpr (IS_UPDATED<Component>) {
+            static const Storage<Component> untracked; // no tags until the first `markUpdated`
+            if (!hasStorage<Component>()) {
+                return untracked;
+            }
+        }
+        ECS_ASSERT(hasStorage<Component>(), "Storage doesn\'t exist");
+        return *static_cast<const Storage<Component>*>(m_storages[detail::world::sequenceID<Component>()].get());
+    }
+
     [[nodiscard]] Entity create() {
         ECS_PROFILER(ZoneScoped);
 
@@ -240,6 +360,38 @@ struct World final : NoCopyNoMove {
         return entity;
     }
 
+    // Creates `entities.size()` entities in the same order as create() would. The entity list is merged once,
+    // so large batches don't shift it for every entity
+    void create(std::span<Entity> entities) {
+        ECS_PROFILER(ZoneScoped);
+
+        if (entities.empty()) {
+            return;
+        }
+
+        // ids below `next` are alive or free
+        auto next = static_cast<Entity>(m_entities.size() + m_free_entities.size());
+        for (auto& entity : entities) {
+            if (m_free_entities.empty()) [[unlikely]] {
+                entity = next++;
+            } else {
+                entity = m_free_entities.back();
+                m_free_entities.pop_back();
+            }
+        }
+
+        auto sorted = TMP_GET(std::vector<Entity>);
+        sorted->assign(entities.begin(), entities.end());
+        std::ranges::sort(*sorted);
+
+        auto middle = m_entities.insert(m_entities.end(), sorted->begin(), sorted->end());
+        if (middle != m_entities.begin() && *std::prev(middle) > *middle) {
+            std::inplace_merge(m_entities.begin(), middle, m_entities.end());
+        }
+
+        notify(entities);
+    }
+
     void destroy(Entity e) {
         ECS_PROFILER(ZoneScoped);
         m_entities_to_destroy.emplace_back(e);
@@ -252,6 +404,7 @@ struct World final : NoCopyNoMove {
 
     void flush() {
         ECS_PROFILER(ZoneScoped);
+        ECS_TRACE("World::flush");
 
         if (m_entities_to_destroy.empty()) {
             return;
@@ -264,7 +417,13 @@ struct World final : NoCopyNoMove {
         }
 
         for (auto& storage : m_storages) {
-            storage->remove(m_entities_to_destroy);
+            if (storage) {
+                storage->remove(m_entities_to_destroy);
+            }
+        }
+
+        for (const auto& func : m_destroy_callback) {
+            func(m_entities_to_destroy);
         }
 
         for (auto entity : m_entities_to_destroy) {
@@ -280,11 +439,10 @@ struct World final : NoCopyNoMove {
         }
 
         if (m_entities_to_destroy.size() > 1) {
-            static std::vector<Entity> result;
-            result.reserve(m_entities.size());
-            std::ranges::set_difference(m_entities, m_entities_to_destroy, std::back_inserter(result));
-            m_entities.swap(result);
-            result.clear();
+            auto result = TMP_GET(std::vector<Entity>);
+            result->reserve(m_entities.size());
+            std::ranges::set_difference(m_entities, m_entities_to_destroy, std::back_inserter(*result));
+            m_entities.swap(*result);
         } else {
             auto pos = std::ranges::lower_bound(m_entities, m_entities_to_destroy.front());
             m_entities.erase(pos);
@@ -301,7 +459,7 @@ struct World final : NoCopyNoMove {
         ECS_ASSERT(isAlive(e), "Entity doesn't exist");
         std::vector<std::string> names;
         for (const auto& storage : m_storages) {
-            if (storage->has(e)) {
+            if (storage && storage->has(e)) {
                 ECS_DEBUG_ONLY(names.emplace_back(storage->name()));
             }
         }
@@ -311,6 +469,11 @@ struct World final : NoCopyNoMove {
 
     void subscribe(std::function<void(Entity)> func) { m_notify_callback.emplace_back(std::move(func)); }
 
+    // called by `flush` with the sorted entities before their ids are freed
+    void subscribeDestroy(std::function<void(std::span<const Entity>)> func) {
+        m_destroy_callback.emplace_back(std::move(func));
+    }
+
     void notify(Entity entity) {
         ECS_PROFILER(ZoneScoped);
 
@@ -329,20 +492,79 @@ struct World final : NoCopyNoMove {
         }
     }
 
+    // Copies the entities and all storages into the oldest of `detail::world::SNAPSHOTS` buffers.
+    // Buffers are reused, so after the first round the snapshot doesn't allocate. Storages which had no components
+    // emplaced, erased or changed (see `get`) since the buffer was written keep their copy. Changes are found by
+    // the ticks, so a snapshot taken in the frame of the copy counts the changes of the whole frame.
+    // Returns `INVALID_SNAPSHOT` if a storage holds components which can't be copied
+    SnapshotHandle snapshot();
+
+    // Brings back the world captured by `snapshot`. Returns false if the snapshot was overwritten.
+    // Storage callbacks are not called, subscribers are notified about the entities alive before or after.
+    // Storages unchanged since the snapshot are not copied and their components are not marked as changed
+    bool restore(SnapshotHandle handle);
+
+    // Memory of the storages, the entity lists, the observers and the snapshots. Thread local TempBuffer pools taken
+    // by `flush`, the filters and the refresh of the observers are not included, TempBuffer doesn't expose their size
+    MemoryReport memoryReport() const;
+
     void optimize(std::size_t storage_id) {
         ECS_PROFILER(ZoneScoped);
+        ECS_TRACE("World::optimize");
 
         assert(m_storages.size());
-        m_storages[storage_id % m_storages.size()]->optimize();
+        if (const auto& storage = m_storages[storage_id % m_storages.size()]) {
+            storage->optimize();
+        }
     }
 
+    // current tick, components emplaced or changed now are stamped with it
+    Tick tick() const noexcept { return m_tick; }
+
+    // called by the registry at the beginning of every frame
+    Tick advanceTick() noexcept { return ++m_tick; }
+
+    void setCompactionPolicy(const CompactionPolicy& policy) noexcept { m_compaction = policy; }
+    const CompactionPolicy& compactionPolicy() const noexcept { return m_compaction; }
+
+    // shrinks the storage if it has been keeping unused memory according to the compaction policy
+    bool compact(std::size_t storage_id, std::uint64_t frame) {
+        if (m_storages.empty()) {
+            return false;
+        }
+
+        const auto& storage = m_storages[storage_id % m_storages.size()];
+        return storage && storage->compact(m_compaction, frame);
+    }
 
 private:
+    template<typename Component>
+    void addStorage() {
+        // generate runtime ID for components.
+        std::ignore = detail::world::sequenceID<Component>();
+        auto id = detail::world::sequenceID<Component>();
+        ECS_ASSERT(!hasStorage<Component>(), "Storage already exists");
+        // other worlds could register more components, their slots stay empty here
+        m_storages.resize(std::max<std::size_t>(m_storages.size(), id + 1));
+        m_storages[id] = std::make_unique<Storage<Component>>();
+        m_storages[id]->setClock(&m_tick);
+    }
+
     std::unique_ptr<Registry>                 m_reg;
     std::vector<Entity>                       m_entities;
     std::vector<Entity>                       m_entities_to_destroy;
     std::vector<std::unique_ptr<StorageBase>> m_storages;
     std::vector<std::function<void(Entity)>>  m_notify_callback;
-    std::list<Entity>                         m_free_entities;
+    std::deque<Entity>                        m_free_entities;
     std::map<std::string, Component>          m_component_name;
+
+    std::vector<std::function<void(std::span<const Entity>)>> m_destroy_callback;
+
+    std::unordered_map<Component, std::pair<IDType, IDType>> m_component_storages; // component and Updated<Component>
+
+    std::array<detail::world::Snapshot, detail::world::SNAPSHOTS> m_snapshots;
+    SnapshotHandle                                                m_next_snapshot = 0;
+
+    CompactionPolicy m_compaction;
+    Tick             m_tick = 1; // zero is older than any change
 };
\ No newline at end of file
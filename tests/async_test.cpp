@@ -0,0 +1,77 @@
+#include <simple-ecs/ECS.h>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+// Async saves are captured at the end of the next frame. A registry destroyed before the frame drops its requests,
+// the futures are completed with an empty snapshot or false instead of a broken promise
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+constexpr int ENTITIES = 100;
+
+std::unique_ptr<World> makeWorld() {
+    auto world = std::make_unique<World>();
+    ComponentRegistrant<Position>(*world).createStorage().addSerialize();
+    for (int i = 0; i < ENTITIES; ++i) {
+        world->emplace<Position>(world->create(), Position{i});
+    }
+    return world;
+}
+
+void frame(World& world) {
+    auto& reg = *world.getRegistry();
+    reg.initNewSystems();
+    reg.prepare();
+    reg.exec();
+}
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+} // namespace
+
+
+int main() {
+    auto  world      = makeWorld();
+    auto& serializer = world->getRegistry()->serializer();
+
+    bool ok = check(!serializer.asyncPending(), "Save is pending without a request");
+
+    auto               data     = serializer.saveAsync();
+    serializer::Output streamed;
+    auto sunk = serializer.saveAsync([&streamed](std::span<const serializer::Data> chunk) {
+        streamed.insert(streamed.end(), chunk.begin(), chunk.end());
+    });
+    ok &= check(serializer.asyncPending(), "Request is not pending");
+    ok &= check(data.wait_for(std::chrono::milliseconds(10)) == std::future_status::timeout, "Saved without a frame");
+
+    // captured at the end of the frame, the world moves on meanwhile
+    frame(*world);
+    ok &= check(!serializer.asyncPending(), "Request is not captured");
+    world->emplace<Position>(world->create());
+
+    auto saved = data.get();
+    ok &= check(sunk.get() && saved == streamed, "Sink and snapshot differ");
+
+    World loaded;
+    ComponentRegistrant<Position>(loaded).createStorage().addSerialize();
+    ok &= check(loaded.getRegistry()->serializer().load(saved), "Async save is not loaded");
+    ok &= check(loaded.entities().size() == ENTITIES, "Entity created after the frame is saved");
+
+    // the registry is gone before the next frame
+    auto dropped      = world->getRegistry()->serializer().saveAsync();
+    auto dropped_sink = world->getRegistry()->serializer().saveAsync([](std::span<const serializer::Data>) {});
+    world.reset();
+    ok &= check(dropped.get().empty() && !dropped_sink.get(), "Dropped request is not reported");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
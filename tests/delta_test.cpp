@@ -0,0 +1,107 @@
+#include <simple-ecs/ECS.h>
+#include <cstdlib>
+
+// Deltas use the same rule of changes as `Changed<T>`: components written through `get` are saved, components read
+// with `get<const T>` are not. Created and destroyed entities are applied to the replica
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+struct Static {
+    int id = 0;
+};
+
+constexpr int ENTITIES = 100;
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+void setup(World& world) { ComponentRegistrant<Position, Static>(world).createStorage().addSerialize(); }
+
+// the replica has the same entities with the same components
+bool same(World& source, World& replica) {
+    if (source.entities() != replica.entities()) {
+        return false;
+    }
+    for (auto e : source.entities()) {
+        if (source.get<const Position>(e).x != replica.get<const Position>(e).x ||
+            source.get<const Static>(e).id != replica.get<const Static>(e).id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main() {
+    World source;
+    setup(source);
+    for (int i = 0; i < ENTITIES; ++i) {
+        auto e = source.create();
+        source.emplace<Position>(e, Position{i});
+        source.emplace<Static>(e, Static{i});
+    }
+
+    World replica;
+    setup(replica);
+
+    auto&                sender   = source.getRegistry()->serializer();
+    auto&                receiver = replica.getRegistry()->serializer();
+    serializer::Baseline baseline;
+
+    // deltas are taken between frames, so the changes of the previous frame are not written again
+    source.advanceTick();
+    bool ok = check(receiver.load(sender.saveDelta(baseline)), "Full delta is not loaded");
+    ok &= check(same(source, replica), "Full delta differs");
+
+    // written through a plain reference, not marked
+    for (auto e : source.entities()) {
+        if (e % 2 == 0) {
+            source.get<Position>(e).x += 1000;
+        }
+    }
+    source.advanceTick();
+    auto written = sender.saveDelta(baseline);
+    ok &= check(receiver.loadDelta(written), "Delta of get is not loaded");
+    ok &= check(same(source, replica), "Component written through get is not in the delta");
+
+    // reads keep the ticks, the replica keeps its own value
+    int sum = 0;
+    for (auto e : source.entities()) {
+        sum += source.get<const Position>(e).x + source.tryGet<const Static>(e)->id;
+    }
+    const auto first               = source.entities().front();
+    replica.get<Position>(first).x = -1;
+    source.advanceTick();
+    auto read = sender.saveDelta(baseline);
+    ok &= check(sum != 0 && read.size() < written.size(), "Delta of reads is not smaller");
+    ok &= check(receiver.loadDelta(read) && replica.get<const Position>(first).x == -1, "Read is saved as a change");
+    replica.get<Position>(first).x = source.get<const Position>(first).x;
+
+    // tryGet is a write like get
+    *source.tryGet<Static>(first) = Static{-5};
+    source.advanceTick();
+    ok &= check(receiver.loadDelta(sender.saveDelta(baseline)), "Delta of tryGet is not loaded");
+    ok &= check(replica.get<const Static>(first).id == -5, "Component written through tryGet is not in the delta");
+
+    // structural changes
+    source.destroy(first);
+    source.flush();
+    auto created = source.create();
+    source.emplace<Position>(created, Position{7});
+    source.emplace<Static>(created, Static{7});
+    source.advanceTick();
+    ok &= check(receiver.loadDelta(sender.saveDelta(baseline)), "Delta of created and destroyed is not loaded");
+    ok &= check(same(source, replica), "Created or destroyed entity is not in the delta");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,122 @@
+#include <simple-ecs/ECS.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Snapshot is `[header][sections][table of contents][footer]`. A world is loaded back unchanged, components can be
+// picked by the table of contents. A flipped byte in any section or in the table and a truncated snapshot fail
+// the load, in memory and in a stream
+
+namespace {
+
+struct Position {
+    int x = 0;
+    int y = 0;
+};
+
+struct Label {
+    std::string text;
+};
+
+constexpr int ENTITIES = 50;
+
+void setup(World& world) {
+    ComponentRegistrant<Position>(world).createStorage().addSerialize();
+    ComponentRegistrant<Label>(world)
+      .createStorage()
+      .setSaveFunc([](const Label& comp, serializer::OutputView& out) { out.writeString(comp.text); })
+      .setLoadFunc([](serializer::InputView& in) -> Label { return {std::string(in.readString())}; });
+}
+
+bool same(World& source, World& loaded) {
+    if (source.entities() != loaded.entities()) {
+        return false;
+    }
+    for (auto e : source.entities()) {
+        const auto& position = loaded.get<const Position>(e);
+        if (position.x != source.get<const Position>(e).x || position.y != source.get<const Position>(e).y ||
+            loaded.get<const Label>(e).text != source.get<const Label>(e).text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool load(std::span<const serializer::Data> data) {
+    World world;
+    setup(world);
+    return world.getRegistry()->serializer().load(data);
+}
+
+bool loadStream(std::span<const serializer::Data> data) {
+    World world;
+    setup(world);
+    return world.getRegistry()->serializer().load([data](std::span<serializer::Data> buffer) mutable {
+        auto size = std::min(buffer.size(), data.size());
+        std::copy_n(data.begin(), size, buffer.begin());
+        data = data.subspan(size);
+        return size;
+    });
+}
+
+bool check(bool ok, const std::string& what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+} // namespace
+
+
+int main() {
+    World source;
+    setup(source);
+    for (int i = 0; i < ENTITIES; ++i) {
+        auto e = source.create();
+        if (i % 3) {
+            source.emplace<Position>(e, Position{i, -i});
+        }
+        if (i % 2) {
+            source.emplace<Label>(e, Label{"entity " + std::to_string(i)});
+        }
+    }
+    auto data = source.getRegistry()->serializer().save();
+
+    World loaded;
+    setup(loaded);
+    bool ok = check(loaded.getRegistry()->serializer().load(data), "Snapshot is not loaded");
+    ok &= check(same(source, loaded), "Loaded world differs");
+
+    World positions;
+    setup(positions);
+    const Component only[] = {ct::ID<Position>};
+    ok &= check(positions.getRegistry()->serializer().load(data, only), "Picked component is not loaded");
+    ok &= check(positions.storage<Position>().size() == source.storage<Position>().size() &&
+                  positions.storage<Label>().size() == 0,
+                "Only the picked component has to be loaded");
+
+    // corrupted loads are reported, only the accepted ones are interesting
+    std::vector<std::string> accepted;
+    spdlog::set_level(spdlog::level::off);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        auto corrupted = data;
+        corrupted[i] ^= 0x5A;
+        if (load(corrupted) || loadStream(corrupted)) {
+            accepted.emplace_back("byte " + std::to_string(i) + " is flipped");
+        }
+    }
+    for (std::size_t size = 0; size < data.size(); ++size) {
+        auto truncated = std::span(data).first(size);
+        if (load(truncated) || loadStream(truncated)) {
+            accepted.emplace_back("truncated to " + std::to_string(size) + " bytes");
+        }
+    }
+    spdlog::set_level(spdlog::level::info);
+
+    for (const auto& snapshot : accepted) {
+        ok = check(false, "Corrupted snapshot is loaded: " + snapshot);
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
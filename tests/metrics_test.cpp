@@ -0,0 +1,110 @@
+#include <simple-ecs/ECS.h>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Histograms keep the count, the sum and the extremes exactly and the percentiles within a bucket. Dumps have
+// a summary per function and observer with escaped names, a file is replaced at once. Frames and functions are
+// recorded by the registry, metrics are empty in the final build
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+using AnyFilter = Filter<Require<Position>>;
+
+void move(OBSERVER(AnyFilter) observer) {
+    for (auto e : observer) {
+        e.get<Position>().x++;
+    }
+}
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+bool contains(const std::string& dump, std::string_view line) { return dump.find(line) != std::string::npos; }
+
+} // namespace
+
+
+int main() {
+    Histogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    bool ok = check(histogram.count() == 1000 && histogram.sum() == 500500, "Count or sum is lost");
+    ok &= check(histogram.min() == 1 && histogram.max() == 1000, "Extremes are lost");
+    ok &= check(histogram.percentile(50.) >= 484 && histogram.percentile(50.) <= 516, "Median is out of its bucket");
+    ok &= check(histogram.percentile(99.) >= 958 && histogram.percentile(99.) <= 1000, "P99 is out of its bucket");
+
+    Metrics metrics;
+    metrics.frames = 3;
+    metrics.frame_time.record(100);
+    auto& function = metrics.functions.emplace_back();
+    function.name  = R"(say "hi")";
+    function.time.record(40);
+    function.entities = 7;
+    metrics.observers.emplace_back().name = "Filter<Position>";
+
+    auto text = dumpMetrics(metrics, MetricsFormat::Text);
+    ok &= check(contains(text, "ecs_frames_total 3\n"), "Text has no frame count");
+    ok &= check(contains(text, R"(ecs_function_time_ns{function="say \"hi\"",quantile="0.5"} 40)"),
+                "Text has no escaped function summary");
+    ok &= check(contains(text, R"(ecs_function_time_ns_count{function="say \"hi\""} 1)"), "Text has no count");
+    ok &= check(contains(text, R"(ecs_function_entities_total{function="say \"hi\""} 7)"), "Text has no entities");
+    ok &= check(contains(text, R"(ecs_observer_entities{observer="Filter<Position>"} 0)"), "Text has no observer");
+
+    auto json = dumpMetrics(metrics, MetricsFormat::Json);
+    ok &= check(contains(json, R"({"frames":3,"frame_time_ns":{"count":1,)"), "Json has no frames");
+    ok &= check(contains(json, R"("name":"say \"hi\"","entities":7,"time_ns":{"count":1,"min":40,)"),
+                "Json has no escaped function");
+
+    auto path = std::filesystem::temp_directory_path() / "simple_ecs_metrics_test.prom";
+    ok &= check(dumpMetrics(metrics, path, MetricsFormat::Text), "Dump is not written");
+    std::stringstream file;
+    file << std::ifstream(path, std::ios::binary).rdbuf();
+    ok &= check(file.str() == text && !std::filesystem::exists(path.string() + ".tmp"), "Dump file differs");
+    std::filesystem::remove(path);
+
+    World world;
+    ComponentRegistrant<Position>(world).createStorage();
+    for (int i = 0; i < 10; ++i) {
+        world.emplace<Position>(world.create());
+    }
+    auto& reg = *world.getRegistry();
+    ECS_REG_EXTERN_FUNC(reg, move);
+    reg.initNewSystems();
+    for (int i = 0; i < 5; ++i) {
+        reg.prepare();
+        reg.exec();
+    }
+
+    auto recorded = reg.metrics();
+#ifdef ECS_FINAL
+    ok &= check(recorded.frames == 0 && recorded.functions.empty(), "Metrics are recorded in the final build");
+#else
+    ok &= check(recorded.frames == 5 && recorded.frame_time.count() == 5, "Frames are not recorded");
+    // the debug system of the world has its own functions
+    auto moved = std::ranges::find(recorded.functions, "move", &FunctionMetrics::name);
+    ok &= check(moved != recorded.functions.end() && moved->time.count() == 5 && moved->entities == 50,
+                "Function is not recorded");
+    ok &= check(!recorded.observers.empty(), "Observer is not recorded");
+
+    reg.resetMetrics();
+    recorded = reg.metrics();
+    ok &= check(recorded.frame_time.empty() &&
+                  std::ranges::all_of(recorded.functions, [](const auto& f) { return f.time.empty(); }),
+                "Metrics are not reset");
+#endif
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,95 @@
+#include <simple-ecs/ECS.h>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+// Columns are split into parts of about the chunk size which are saved in parallel. Every component is saved once,
+// the parts are written in order, so a streamed save with small chunks loads the same world as a save in memory
+
+namespace {
+
+struct Position {
+    int x = 0;
+    int y = 0;
+};
+
+struct Label {
+    std::string text;
+};
+
+constexpr int         ENTITIES = 20000;
+constexpr std::size_t CHUNK    = 1024; // hundreds of parts per column
+
+std::atomic_int g_saved = 0;
+
+void setup(World& world) {
+    ComponentRegistrant<Position>(world).createStorage().addSerialize();
+    ComponentRegistrant<Label>(world)
+      .createStorage()
+      .setSaveFunc([](const Label& comp, serializer::OutputView& out) {
+          g_saved++;
+          out.writeString(comp.text);
+      })
+      .setLoadFunc([](serializer::InputView& in) -> Label { return {std::string(in.readString())}; });
+}
+
+bool same(World& source, World& loaded) {
+    if (source.entities() != loaded.entities()) {
+        return false;
+    }
+    for (auto e : source.entities()) {
+        const auto& position = loaded.get<const Position>(e);
+        if (position.x != static_cast<int>(e) || position.y != -static_cast<int>(e) ||
+            loaded.get<const Label>(e).text != source.get<const Label>(e).text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+} // namespace
+
+
+int main() {
+    World source;
+    setup(source);
+    for (int i = 0; i < ENTITIES; ++i) {
+        auto e = source.create();
+        source.emplace<Position>(e, Position{static_cast<int>(e), -static_cast<int>(e)});
+        source.emplace<Label>(e, Label{"entity " + std::to_string(e)});
+    }
+    auto& serializer = source.getRegistry()->serializer();
+
+    auto in_memory = serializer.save();
+    bool ok        = check(g_saved == ENTITIES, "Custom saver is not called once per component");
+
+    g_saved = 0;
+    serializer::Output streamed;
+    std::size_t        chunks       = 0;
+    std::size_t        short_chunks = 0;
+    serializer.save(
+      [&](std::span<const serializer::Data> chunk) {
+          short_chunks += chunk.size() != CHUNK;
+          chunks++;
+          streamed.insert(streamed.end(), chunk.begin(), chunk.end());
+      },
+      CHUNK);
+    ok &= check(g_saved == ENTITIES, "Custom saver is not called once per component of the stream");
+    ok &= check(chunks > 100 && short_chunks <= 1, "Stream is not cut into chunks of the same size");
+
+    for (const auto* data : {&in_memory, &streamed}) {
+        World loaded;
+        setup(loaded);
+        ok &= check(loaded.getRegistry()->serializer().load(*data), "Save is not loaded");
+        ok &= check(same(source, loaded), "Loaded world differs");
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,89 @@
+#include <simple-ecs/ECS.h>
+#include <cstdlib>
+#include <vector>
+
+// Two functions share the observer of one filter, each of them slices it by its own runs.
+// Every entity has to be visited once per N runs of each function, whatever the other one does.
+// Outside of the functions the run is passed explicitly
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+using SliceFilter = Filter<Require<Position>>;
+
+constexpr std::size_t ENTITIES = 1000;
+
+std::vector<int> g_halves(ENTITIES);
+std::vector<int> g_thirds(ENTITIES);
+
+void halves(OBSERVER(SliceFilter) observer) {
+    for (auto e : observer.slice(2)) {
+        g_halves[e]++;
+    }
+}
+
+// a second call in the same run returns the same part
+void thirds(OBSERVER(SliceFilter) observer) {
+    std::vector<Entity> first;
+    for (auto e : observer.slice(3)) {
+        g_thirds[e]++;
+        first.emplace_back(e);
+    }
+
+    std::vector<Entity> second;
+    for (auto e : observer.slice(3)) {
+        second.emplace_back(e);
+    }
+    if (first != second) {
+        g_thirds.assign(ENTITIES, -1);
+    }
+}
+
+bool visited(const std::vector<int>& counts, int times, const char* name) {
+    for (std::size_t e = 0; e < counts.size(); ++e) {
+        if (counts[e] != times) {
+            spdlog::error("{}: entity {} is visited {} times instead of {}", name, e, counts[e], times);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main() {
+    World world;
+    ComponentRegistrant<Position>(world).createStorage();
+
+    auto& reg = *world.getRegistry();
+    ECS_REG_EXTERN_FUNC(reg, halves);
+    ECS_REG_EXTERN_FUNC(reg, thirds);
+    reg.initNewSystems();
+
+    for (std::size_t i = 0; i < ENTITIES; ++i) {
+        world.emplace<Position>(world.create());
+    }
+
+    // 6 frames are 3 rounds of halves and 2 rounds of thirds
+    for (int frame = 0; frame < 6; ++frame) {
+        reg.prepare();
+        reg.exec();
+    }
+
+    bool ok = visited(g_halves, 3, "halves") && visited(g_thirds, 2, "thirds");
+
+    // outside of a function the run is passed, the parts of runs 0..N-1 cover every entity once
+    Observer<SliceFilter> observer(world);
+    std::vector<int>      explicit_runs(ENTITIES);
+    for (std::uint64_t run = 0; run < 4; ++run) {
+        for (auto e : observer.slice(4, run)) {
+            explicit_runs[e]++;
+        }
+    }
+    ok &= visited(explicit_runs, 1, "explicit runs");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
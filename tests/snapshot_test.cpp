@@ -0,0 +1,94 @@
+#include <simple-ecs/ECS.h>
+#include <cstdlib>
+
+// Snapshots keep the copies of the storages which were not changed since the buffer was written. A storage written
+// through `get`, changed by a restore or changed between two snapshots has to be copied again, also when it's written
+// in the frame of the copy
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+struct Static {
+    int id = 0;
+};
+
+constexpr std::size_t ENTITIES = 100;
+
+int sum(World& world) {
+    int result = 0;
+    for (auto e : world.entities()) {
+        result += world.get<const Position>(e).x;
+    }
+    return result;
+}
+
+// one frame
+void move(World& world, int dx) {
+    world.advanceTick();
+    for (auto e : world.entities()) {
+        world.get<Position>(e).x += dx;
+    }
+}
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+} // namespace
+
+
+int main() {
+    World world;
+    ComponentRegistrant<Position, Static>(world).createStorage();
+    for (std::size_t i = 0; i < ENTITIES; ++i) {
+        auto e = world.create();
+        world.emplace<Position>(e);
+        world.emplace<Static>(e, Static{static_cast<int>(i)});
+    }
+
+    // every buffer is written once, then the same buffers are reused
+    for (std::size_t i = 0; i < detail::world::SNAPSHOTS; ++i) {
+        move(world, 1);
+        std::ignore = world.snapshot();
+    }
+    auto first  = world.snapshot(); // overwrites the first buffer, x = 8
+    move(world, 1);
+    auto second = world.snapshot(); // x = 9
+
+    bool ok = check(world.restore(first) && sum(world) == 8 * static_cast<int>(ENTITIES), "First is not restored");
+    ok &= check(world.restore(second) && sum(world) == 9 * static_cast<int>(ENTITIES), "Second is not restored");
+
+    // storages written after a restore are copied again
+    move(world, 5);
+    ok &= check(world.restore(second) && sum(world) == 9 * static_cast<int>(ENTITIES), "Second is not restored again");
+    auto third = world.snapshot();
+    move(world, 1);
+    ok &= check(world.restore(third) && sum(world) == 9 * static_cast<int>(ENTITIES), "Third is not restored");
+
+    // written after the snapshot in the same frame
+    for (std::size_t i = 0; i < detail::world::SNAPSHOTS; ++i) {
+        std::ignore = world.snapshot();
+    }
+    for (auto e : world.entities()) {
+        world.get<Position>(e).x = 1;
+    }
+    auto same_frame = world.snapshot();
+    move(world, 1);
+    ok &= check(world.restore(same_frame) && sum(world) == static_cast<int>(ENTITIES), "Write in the frame is lost");
+    auto fourth = world.snapshot();
+
+    // entities created after the snapshot are removed with their components
+    auto e = world.create();
+    world.emplace<Position>(e, Position{100});
+    ok &= check(world.restore(fourth) && world.size() == ENTITIES, "Created entity is not removed");
+    ok &= check(world.storage<Position>().size() == ENTITIES, "Component of the created entity is not removed");
+    ok &= check(world.storage<Static>().size() == ENTITIES, "Unchanged storage is changed");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,73 @@
+#include <simple-ecs/ECS.h>
+#include <atomic>
+#include <cstdlib>
+
+// Worlds stepped together are calculated in parallel and don't see each other. Captures of the async saves are done
+// by the calling thread after the frames, so a save requested before the step has the state of that frame
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+using MoveFilter = Filter<Require<Position>>;
+
+std::atomic_int g_frames = 0;
+
+void move(OBSERVER(MoveFilter) observer) {
+    for (auto e : observer) {
+        e.get<Position>().x++;
+    }
+    g_frames++;
+}
+
+int sum(World& world) {
+    int result = 0;
+    for (auto e : world.entities()) {
+        result += world.get<const Position>(e).x;
+    }
+    return result;
+}
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+} // namespace
+
+
+int main() {
+    constexpr int STEPS = 10;
+
+    World first;
+    World second;
+    for (auto [world, entities] : {std::pair{&first, 10}, std::pair{&second, 20}}) {
+        ComponentRegistrant<Position>(*world).createStorage().addSerialize();
+        for (int i = 0; i < entities; ++i) {
+            world->emplace<Position>(world->create());
+        }
+        auto& reg = *world->getRegistry();
+        ECS_REG_EXTERN_FUNC(reg, move);
+    }
+
+    std::vector<World*> worlds{&first, &second};
+    for (int i = 0; i < STEPS - 1; ++i) {
+        Registry::step(worlds);
+    }
+    auto saved = second.getRegistry()->serializer().saveAsync();
+    Registry::step(worlds);
+
+    bool ok = check(g_frames == 2 * STEPS, "Frames are lost");
+    ok &= check(sum(first) == 10 * STEPS && sum(second) == 20 * STEPS, "Worlds are not moved");
+
+    World loaded;
+    ComponentRegistrant<Position>(loaded).createStorage().addSerialize();
+    ok &= check(loaded.getRegistry()->serializer().load(saved.get()), "Async save is not loaded");
+    ok &= check(sum(loaded) == 20 * STEPS, "Async save doesn't have the state of the step");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
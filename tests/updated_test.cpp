@@ -0,0 +1,68 @@
+#include <simple-ecs/ECS.h>
+#include <cstdlib>
+
+// Tag storages are created on demand. Components which were never tagged have none, tags marked before a filter
+// with `Updated` is registered are kept. Loaded components are tagged only if their tags are tracked
+
+namespace {
+
+struct Position {
+    int x = 0;
+};
+
+struct Health {
+    int hp = 0;
+};
+
+using UpdatedFilter = Filter<Require<Updated<Position>>>;
+
+std::size_t g_updated = 0;
+
+void countUpdated(OBSERVER(UpdatedFilter) observer) { g_updated = observer.size(); }
+
+bool check(bool ok, const char* what) {
+    if (!ok) {
+        spdlog::error("{}", what);
+    }
+    return ok;
+}
+
+} // namespace
+
+
+int main() {
+    World        world;
+    const World& view = world; // const access doesn't create tag storages
+    ComponentRegistrant<Position, Health>(world).createStorage();
+
+    auto e = world.create();
+    world.emplace<Position>(e);
+    world.emplace<Health>(e);
+
+    bool ok = check(!world.has<Updated<Health>>(e), "Untracked component has a tag");
+    ok &= check(view.storage<Updated<Health>>().empty(), "Untracked component has tags");
+
+    world.markUpdated<Position>(e);
+    auto& reg = *world.getRegistry();
+    ECS_REG_EXTERN_FUNC(reg, countUpdated);
+    reg.initNewSystems();
+    reg.prepare();
+    reg.exec();
+    ok &= check(g_updated == 1, "Tag marked before the filter is lost");
+
+    world.clearUpdateTag<Position>(e);
+    world.clearUpdateTag<Health>(e);
+    ok &= check(!world.has<Updated<Position>>(e), "Tag is not cleared");
+
+    ComponentRegistrant<Position, Health>(world).addSerialize();
+    ok &= check(!world.hasStorage<Updated<Health>>(), "Loader creates a tag storage");
+
+    auto data = reg.serializer().save();
+    world.destroy(e);
+    world.flush();
+    ok &= check(reg.serializer().load(data), "Snapshot is not loaded");
+    ok &= check(view.storage<Updated<Position>>().size() == 1, "Loaded tracked component is not tagged");
+    ok &= check(!world.hasStorage<Updated<Health>>(), "Load creates a tag storage");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}